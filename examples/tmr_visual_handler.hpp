@@ -69,6 +69,8 @@ class TMErrorHandler final : public tm_robot_listener::ListenerHandle {
     ++this->state_;
   }
 
+  std::vector<std::string> listen_node_messages() const override { return {"VisionFail", "UltrasonicFail"}; }
+
   tm_robot_listener::Decision start_task(std::vector<std::string> const& t_name) override {
     if (t_name[0] == "VisionFail" or t_name[0] == "UltrasonicFail") {
       this->state_ = HandlerState::ChangePayload;
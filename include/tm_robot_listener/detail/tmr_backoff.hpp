@@ -0,0 +1,70 @@
+#ifndef TMR_BACKOFF_HPP_
+#define TMR_BACKOFF_HPP_
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+namespace tm_robot_listener {
+namespace detail {
+
+/**
+ * @brief Exponential backoff with jitter. The first delay is the minimum delay, every delay afterwards is factor times
+ *        the previous one, until it reaches the maximum delay. Each delay is spread randomly by the jitter ratio, so
+ *        that listeners losing their robots at the same time, e.g. on a power cut, don't retry in lockstep.
+ *
+ * @note  The minimum delay is at least 1 ms, a zero delay would never grow
+ */
+class Backoff {
+ public:
+  using Duration = std::chrono::steady_clock::duration;
+
+ private:
+  Duration min_delay_{std::chrono::milliseconds{100}};
+  Duration max_delay_{std::chrono::seconds{10}};
+  double factor_ = 2.0;
+  double jitter_ = 0.0;
+  Duration next_{min_delay_}; /*!< delay before jitter of the next attempt */
+
+ public:
+  Backoff() = default;
+
+  /**
+   * @param t_min_delay delay of the first attempt
+   * @param t_max_delay delay never grows beyond this, jitter included
+   * @param t_factor    growth of the delay per attempt, at least 1
+   * @param t_jitter    ratio the delay is spread by, e.g. 0.2 for +-20%, clamped to [0, 1]
+   */
+  Backoff(Duration const t_min_delay, Duration const t_max_delay, double const t_factor, double const t_jitter) noexcept
+    : min_delay_{std::max<Duration>(t_min_delay, std::chrono::milliseconds{1})},
+      max_delay_{std::max(t_max_delay, min_delay_)},
+      factor_{std::max(t_factor, 1.0)},
+      jitter_{std::min(std::max(t_jitter, 0.0), 1.0)},
+      next_{min_delay_} {}
+
+  /**
+   * @brief This function returns the delay before the next attempt, and grows the delay of the one after
+   *
+   * @param t_rng uniform random bit generator, e.g. std::minstd_rand
+   */
+  template <typename URNG>
+  Duration next_delay(URNG& t_rng) noexcept {
+    using std::chrono::duration_cast;
+    auto const base = this->next_;
+    this->next_     = std::min(this->max_delay_, duration_cast<Duration>(base * this->factor_));
+
+    std::uniform_real_distribution<double> spread{-this->jitter_, this->jitter_};
+    auto const delay = duration_cast<Duration>(base * (1.0 + spread(t_rng)));
+    return std::min(delay, this->max_delay_);
+  }
+
+  /**
+   * @brief This function starts over from the minimum delay, e.g. once connected
+   */
+  void reset() noexcept { this->next_ = this->min_delay_; }
+};
+
+}  // namespace detail
+}  // namespace tm_robot_listener
+
+#endif
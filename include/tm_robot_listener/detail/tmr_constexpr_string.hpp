@@ -1,6 +1,9 @@
 #ifndef TMR_CONSTEXPR_STRING_HPP_
 #define TMR_CONSTEXPR_STRING_HPP_
 
+#include <cstddef>
+#include <string>
+
 namespace tm_robot_listener {
 namespace detail {
 
@@ -48,7 +51,32 @@ struct ConstString {
   }
 };
 
+constexpr bool is_var_name_head(char const t_char) noexcept {
+  return (t_char >= 'a' and t_char <= 'z') or (t_char >= 'A' and t_char <= 'Z') or t_char == '_';
+}
+
+/**
+ * @brief This function checks whether [t_first, t_last) is a valid name of TM variable, i.e., [a-zA-Z_][a-zA-Z0-9_]*
+ */
+constexpr bool is_valid_var_name(char const* t_first, char const* const t_last) noexcept {
+  if (t_first == t_last or not is_var_name_head(*t_first)) {
+    return false;
+  }
+
+  for (++t_first; t_first != t_last; ++t_first) {
+    if (not is_var_name_head(*t_first) and not(*t_first >= '0' and *t_first <= '9')) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+inline bool is_valid_var_name(std::string const& t_name) noexcept {
+  return is_valid_var_name(t_name.data(), t_name.data() + t_name.size());
+}
+
 }  // namespace detail
 }  // namespace tm_robot_listener
 
-#endif
\ No newline at end of file
+#endif
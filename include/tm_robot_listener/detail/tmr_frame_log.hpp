@@ -0,0 +1,109 @@
+#ifndef TMR_FRAME_LOG_HPP_
+#define TMR_FRAME_LOG_HPP_
+
+#include <boost/utility/string_ref.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+
+namespace tm_robot_listener {
+
+/**
+ * @brief Lock-free single producer single consumer ring of raw frames. The I/O thread only copies the bytes into a
+ *        preallocated slot, formatting and printing are left to whoever drains the log. If the log is full, the frame
+ *        is dropped and counted instead of blocking the I/O thread.
+ *
+ * @tparam SlotCount  number of frames the log can hold, must be power of 2
+ * @tparam SlotSize   number of bytes kept per frame, longer frames are truncated
+ */
+template <std::size_t SlotCount, std::size_t SlotSize>
+class FrameLog {
+  static_assert(SlotCount != 0 and (SlotCount & (SlotCount - 1)) == 0, "SlotCount must be power of 2");
+
+ public:
+  enum class Direction : std::uint8_t { Received, Sent };
+
+  struct Entry {
+    std::chrono::system_clock::time_point stamp_;
+    std::size_t frame_size_; /*!< size of the frame, may be larger than SlotSize */
+    Direction direction_;
+    std::array<char, SlotSize> data_;
+
+    /**
+     * @brief This function returns the bytes kept, without the trailing "\r\n"
+     */
+    boost::string_ref frame() const noexcept {
+      boost::string_ref ret_val{this->data_.data(), std::min(this->frame_size_, SlotSize)};
+      return ret_val.ends_with("\r\n") ? ret_val.substr(0, ret_val.size() - 2) : ret_val;
+    }
+
+    bool truncated() const noexcept { return this->frame_size_ > SlotSize; }
+  };
+
+ private:
+  static constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+  std::array<Entry, SlotCount> entries_{};
+
+  // head_ and tail_ are written by different threads, keep them away from each other
+  std::atomic<std::size_t> head_{0}; /*!< next slot to write, owned by the producer */
+  char head_padding_[CACHE_LINE_SIZE]{};
+  std::atomic<std::size_t> tail_{0}; /*!< next slot to read, owned by the consumer */
+  char tail_padding_[CACHE_LINE_SIZE]{};
+  std::atomic<std::size_t> dropped_{0};
+
+ public:
+  /**
+   * @brief This function copies t_frame into the log, it never blocks nor allocates, producer only
+   *
+   * @return true if the frame is logged, false if the log is full
+   */
+  bool push(Direction const t_direction, boost::string_ref const t_frame) noexcept {
+    auto const head = this->head_.load(std::memory_order_relaxed);
+    if (head - this->tail_.load(std::memory_order_acquire) == SlotCount) {
+      this->dropped_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+
+    auto& entry       = this->entries_[head & (SlotCount - 1)];
+    entry.stamp_      = std::chrono::system_clock::now();
+    entry.frame_size_ = t_frame.size();
+    entry.direction_  = t_direction;
+    std::memcpy(entry.data_.data(), t_frame.data(), std::min(t_frame.size(), SlotSize));
+
+    this->head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief This function passes every logged frame to t_func in order and frees their slots, consumer only
+   *
+   * @param t_func callable with signature void(Entry const&)
+   * @return number of frames drained
+   */
+  template <typename Func>
+  std::size_t drain(Func t_func) {
+    auto const head = this->head_.load(std::memory_order_acquire);
+    auto tail       = this->tail_.load(std::memory_order_relaxed);
+    auto const size = head - tail;
+
+    for (; tail != head; ++tail) {
+      t_func(static_cast<Entry const&>(this->entries_[tail & (SlotCount - 1)]));
+      this->tail_.store(tail + 1, std::memory_order_release);
+    }
+
+    return size;
+  }
+
+  /**
+   * @brief This function returns the number of frames dropped since last call
+   */
+  std::size_t take_dropped() noexcept { return this->dropped_.exchange(0, std::memory_order_relaxed); }
+};
+
+}  // namespace tm_robot_listener
+
+#endif
@@ -0,0 +1,163 @@
+#ifndef TMR_FRAME_PARSER_HPP_
+#define TMR_FRAME_PARSER_HPP_
+
+#include <boost/utility/string_ref.hpp>
+#include <cstddef>
+
+namespace tm_robot_listener {
+
+/**
+ * @brief Non-owning view of a message sent from TM robot, i.e., "$HEADER,LENGTH,DATA,*CS\r\n". All members refer to
+ *        the buffer passed to parse_frame, therefore the view must not outlive the buffer.
+ */
+struct FrameView {
+  enum class Error { None, Malformed, BadLength, BadChecksum };
+
+  boost::string_ref header_{};    /*!< header including '$', e.g. $TMSCT */
+  boost::string_ref length_{};    /*!< length field, as is, verified against the size of payload */
+  boost::string_ref payload_{};   /*!< data section, without the comma in front of the checksum */
+  boost::string_ref checksum_{};  /*!< checksum field, without '*', verified against the xor of the frame */
+  Error error_ = Error::Malformed;
+
+  bool valid() const noexcept { return this->error_ == Error::None; }
+};
+
+/**
+ * @brief Allocation free tokenizer over a string_ref. Empty fields are skipped, same as boost::char_separator does.
+ *
+ * @code{.cpp}
+ *
+ *    FieldTokenizer fields{"OK;2;3", ';'};
+ *    for (boost::string_ref field; fields.next(field);) {
+ *      // "OK", "2", "3"
+ *    }
+ *
+ * @endcode
+ */
+class FieldTokenizer {
+ private:
+  boost::string_ref remain_;
+  char delimiter_;
+
+ public:
+  FieldTokenizer(boost::string_ref const t_input, char const t_delimiter) noexcept
+    : remain_{t_input}, delimiter_{t_delimiter} {}
+
+  /**
+   * @brief This function extracts next non-empty field
+   *
+   * @param t_field [out] next field, untouched if there is no more field
+   * @return true if a field is extracted, false otherwise
+   */
+  bool next(boost::string_ref& t_field) noexcept {
+    while (not this->remain_.empty()) {
+      auto const pos   = this->remain_.find(this->delimiter_);
+      auto const field = this->remain_.substr(0, pos);
+      this->remain_    = pos == boost::string_ref::npos ? boost::string_ref{} : this->remain_.substr(pos + 1);
+
+      if (not field.empty()) {
+        t_field = field;
+        return true;
+      }
+    }
+
+    return false;
+  }
+};
+
+namespace detail {
+
+/**
+ * @brief This function converts one hexadecimal digit to its value
+ *
+ * @return value of the digit, -1 if t_digit is not a hexadecimal digit
+ */
+constexpr int hex_digit_value(char const t_digit) noexcept {
+  return (t_digit >= '0' and t_digit <= '9')   ? t_digit - '0'
+         : (t_digit >= 'A' and t_digit <= 'F') ? t_digit - 'A' + 10
+         : (t_digit >= 'a' and t_digit <= 'f') ? t_digit - 'a' + 10
+                                               : -1;
+}
+
+}  // namespace detail
+
+/**
+ * @brief This function splits the message sent from TM robot into header, length, payload and checksum, without
+ *        copying or allocating. The xor checksum and the length of the payload are accumulated in the same scan,
+ *        so that corrupted messages are rejected before anyone tokenizes them.
+ *
+ * @param t_frame one message, trailing "\r\n" is optional
+ * @return view of the message, FrameView::valid() returns false if the message is malformed, or its length or
+ *         checksum doesn't match
+ *
+ * @note  The payload ends at the last ",*", since TMSTA data may contain '*'
+ */
+inline FrameView parse_frame(boost::string_ref t_frame) noexcept {
+  constexpr auto npos = boost::string_ref::npos;
+  FrameView frame;
+
+  if (t_frame.ends_with("\r\n")) {
+    t_frame.remove_suffix(2);
+  }
+
+  if (t_frame.empty() or t_frame.front() != '$') {
+    return frame;
+  }
+
+  std::size_t header_end = npos;
+  std::size_t length_end = npos;
+  std::size_t star       = npos;
+  std::size_t length     = 0;
+  bool length_is_number  = true;
+  unsigned xor_sum       = 0;
+  unsigned xor_at_star   = 0;
+
+  for (std::size_t i = 1; i < t_frame.size(); ++i) {
+    auto const c = t_frame[i];
+    if (c == '*' and t_frame[i - 1] == ',' and length_end != npos) {
+      star        = i;
+      xor_at_star = xor_sum;
+    }
+
+    xor_sum ^= static_cast<unsigned char>(c);
+
+    if (length_end != npos) {
+      continue;
+    }
+
+    if (c == ',' and header_end == npos) {
+      header_end = i;
+    } else if (c == ',') {
+      length_end = i;
+    } else if (header_end != npos) {
+      length_is_number = length_is_number and c >= '0' and c <= '9';
+      length           = length * 10 + static_cast<std::size_t>(c - '0');
+    }
+  }
+
+  if (star == npos or star < length_end + 2) {
+    return frame;
+  }
+
+  frame.header_   = t_frame.substr(0, header_end);
+  frame.length_   = t_frame.substr(header_end + 1, length_end - header_end - 1);
+  frame.payload_  = t_frame.substr(length_end + 1, star - length_end - 2);
+  frame.checksum_ = t_frame.substr(star + 1);
+
+  if (not length_is_number or frame.length_.empty() or length != frame.payload_.size()) {
+    frame.error_ = FrameView::Error::BadLength;
+  } else if (frame.checksum_.size() != 2 or detail::hex_digit_value(frame.checksum_[0]) < 0 or
+             detail::hex_digit_value(frame.checksum_[1]) < 0 or
+             static_cast<unsigned>(detail::hex_digit_value(frame.checksum_[0]) * 16 +
+                                   detail::hex_digit_value(frame.checksum_[1])) != xor_at_star) {
+    frame.error_ = FrameView::Error::BadChecksum;
+  } else {
+    frame.error_ = FrameView::Error::None;
+  }
+
+  return frame;
+}
+
+}  // namespace tm_robot_listener
+
+#endif
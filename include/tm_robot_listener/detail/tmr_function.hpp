@@ -3,6 +3,8 @@
 
 #include <boost/fusion/container/vector.hpp>
 #include <boost/fusion/include/find.hpp>
+#include <cstring>
+#include <string>
 
 #include "tmr_command.hpp"
 #include "tmr_constexpr_string.hpp"
@@ -22,6 +24,9 @@ namespace detail {
  */
 template <typename... ArgTypes>
 class Function {
+ private:
+  static constexpr std::size_t ARG_SIZE_HINT = 8; /*!< average length of an argument, to reserve the call once */
+
  public:
   /**
    * @brief operator() for best syntax resemblance
@@ -31,9 +36,27 @@ class Function {
    * @return string of the function call itself
    */
   template <typename PrintPolicy>
-  auto operator()(PrintPolicy const& t_printer, std::string const& t_name,
+  auto operator()(PrintPolicy const& t_printer, char const* const t_name,
                   FundamentalType<ArgTypes> const&... t_args) const noexcept {
-    return t_printer(t_name, boost::algorithm::join(std::vector<std::string>{t_args.to_str()...}, ","));
+    std::string ret_val;
+    ret_val.reserve(std::strlen(t_name) + 2 + ARG_SIZE_HINT * sizeof...(ArgTypes));
+    t_printer.begin(ret_val, t_name);
+
+    bool first = true;
+    auto const append_arg = [&ret_val, &first](auto const& t_arg) {
+      if (not first) {
+        ret_val.push_back(',');
+      }
+      first = false;
+      t_arg.append_to(ret_val);
+      return 0;
+    };
+    int const expand[] = {0, append_arg(t_args)...};
+    static_cast<void>(expand);
+    static_cast<void>(append_arg);  // unused if the function takes no argument
+
+    t_printer.end(ret_val);
+    return ret_val;
   }
 };
 
@@ -79,7 +102,7 @@ struct FunctionSet {
     static_assert(not std::is_same<FindResult, EndType>::value, "Function signature not match");
 
     constexpr TargetFunctor function_call;
-    return Command<Tag>{function_call(PrintPolicy{}, this->name_.to_std_str(), t_arguments...)};
+    return Command<Tag>{function_call(PrintPolicy{}, this->name_.name_, t_arguments...)};
   }
 };
 
@@ -125,32 +148,30 @@ namespace detail {
  * @brief
  */
 struct MotionFnCallPrinter {
-  auto operator()(std::string const& t_name, std::string const& t_input) const noexcept {
-    return t_name + '(' + t_input + ')';
-  }
+  void begin(std::string& t_out, char const* const t_name) const noexcept { t_out.append(t_name).push_back('('); }
+  void end(std::string& t_out) const noexcept { t_out.push_back(')'); }
 };
 
 struct SubCmdCallPrinter {
-  auto operator()(std::string const& t_name, std::string const& t_input) const noexcept {
-    return t_name + ',' + t_input;
-  }
+  void begin(std::string& t_out, char const* const t_name) const noexcept { t_out.append(t_name).push_back(','); }
+  void end(std::string& /*unused*/) const noexcept {}
 };
 
 /**
- * @brief
+ * @brief This function returns the delimiter to put in front of the t_index-th item of the data section, i.e., items
+ *        are separated by comma, except for TMSCT, whose commands (all items after ID) are separated by "\r\n"
  *
- * @tparam T
+ * @tparam T  Header tag
+ * @param t_index index of the item, must be greater than 0
  */
 template <typename T>
-inline auto assemble_to_msg(std::vector<std::string> const& t_input) noexcept {
-  return boost::algorithm::join(t_input, ",");
+constexpr char const* command_delimiter(std::size_t const /*t_index*/) noexcept {
+  return ",";
 }
 
 template <>
-inline auto assemble_to_msg<TMSCTTag>(std::vector<std::string> const& t_input) noexcept {
-  auto const id   = t_input.front();
-  auto const data = std::vector<std::string>{std::next(t_input.begin()), t_input.end()};
-  return id + ',' + boost::algorithm::join(data, "\r\n");
+constexpr char const* command_delimiter<TMSCTTag>(std::size_t const t_index) noexcept {
+  return t_index == 1 ? "," : "\r\n";
 }
 
 }  // namespace detail
@@ -56,6 +56,17 @@ class FundamentalType {
     return value_to_string<T>{}(*val);
   }
 
+  /**
+   * @brief This function appends the argument to t_out, same as to_str
+   */
+  void append_to(std::string& t_out) const noexcept {
+    if (auto const val = boost::get<Variable<T>>(&this->val_)) {
+      val->render(t_out);
+    } else {
+      tm_robot_listener::detail::append_value(t_out, *boost::get<T>(&this->val_));
+    }
+  }
+
  private:
   operating_t val_;
 };
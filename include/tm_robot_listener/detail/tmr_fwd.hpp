@@ -3,7 +3,13 @@
 
 namespace tm_robot_listener {
 
-template <typename T>
+namespace detail {
+
+struct RenderedNode;
+
+}  // namespace detail
+
+template <typename T, typename Node = detail::RenderedNode>
 struct Expression;
 
 template <typename T>
@@ -26,6 +32,9 @@ class Header;
 template <typename Tag>
 class HeaderProductBuilder;
 
+template <typename Tag>
+class PreparedScript;
+
 }  // namespace motion_function
 }  // namespace tm_robot_listener
 
@@ -0,0 +1,96 @@
+#ifndef TMR_HANDLER_INDEX_HPP_
+#define TMR_HANDLER_INDEX_HPP_
+
+#include <cstddef>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace tm_robot_listener {
+namespace detail {
+
+/**
+ * @brief Index from listen node message to the handlers that may accept it, built once when the handlers are loaded.
+ *        Handlers that declare no message, see ListenerHandle::listen_node_messages, are probed for every message.
+ *
+ * @note  Candidates are probed in the order the handlers are loaded, same as a linear search over all of them would
+ */
+class HandlerIndex {
+ private:
+  std::unordered_map<std::string, std::vector<std::size_t>> by_message_;
+  std::vector<std::size_t> dynamic_; /*!< handlers without declared message */
+  std::size_t size_ = 0;
+
+ public:
+  static constexpr std::size_t NOT_FOUND = std::numeric_limits<std::size_t>::max();
+
+  HandlerIndex() = default;
+
+  /**
+   * @param t_handlers  range of pointers to ListenerHandle
+   */
+  template <typename Handlers>
+  explicit HandlerIndex(Handlers const& t_handlers) {
+    for (auto const& handler : t_handlers) {
+      this->add(handler->listen_node_messages());
+    }
+  }
+
+  /**
+   * @brief This function appends the next handler, the one loaded after every handler added so far
+   *
+   * @param t_messages  listen node messages the handler may accept, empty if they are not known in advance
+   */
+  void add(std::vector<std::string> const& t_messages) {
+    auto const index = this->size_++;
+    if (t_messages.empty()) {
+      this->dynamic_.push_back(index);
+    }
+
+    for (auto const& message : t_messages) {
+      auto& candidates = this->by_message_[message];
+      if (candidates.empty() or candidates.back() != index) {
+        candidates.push_back(index);
+      }
+    }
+  }
+
+  /**
+   * @brief This function returns the first candidate for t_message that satisfies t_pred
+   *
+   * @param t_pred  callable with signature bool(std::size_t), called with the index of each candidate in load order
+   * @return index of the handler, NOT_FOUND if none satisfies t_pred
+   */
+  template <typename Pred>
+  std::size_t find(std::string const& t_message, Pred t_pred) const {
+    static std::vector<std::size_t> const NO_CANDIDATE;
+
+    auto const found      = this->by_message_.find(t_message);
+    auto const& indexed   = found == this->by_message_.end() ? NO_CANDIDATE : found->second;
+    auto indexed_iter     = indexed.begin();
+    auto dynamic_iter     = this->dynamic_.begin();
+
+    while (indexed_iter != indexed.end() or dynamic_iter != this->dynamic_.end()) {
+      auto& next = dynamic_iter == this->dynamic_.end() or
+                       (indexed_iter != indexed.end() and *indexed_iter < *dynamic_iter)
+                     ? indexed_iter
+                     : dynamic_iter;
+      auto const candidate = *next++;
+      if (t_pred(candidate)) {
+        return candidate;
+      }
+    }
+
+    return NOT_FOUND;
+  }
+
+  std::size_t dynamic_count() const noexcept { return this->dynamic_.size(); }
+
+  std::size_t size() const noexcept { return this->size_; }
+};
+
+}  // namespace detail
+}  // namespace tm_robot_listener
+
+#endif
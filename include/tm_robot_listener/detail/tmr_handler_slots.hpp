@@ -0,0 +1,164 @@
+#ifndef TMR_HANDLER_SLOTS_HPP_
+#define TMR_HANDLER_SLOTS_HPP_
+
+#include <xmlrpcpp/XmlRpcValue.h>
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "tm_robot_listener/detail/tmr_handler_index.hpp"
+
+namespace tm_robot_listener {
+namespace detail {
+
+using LazyMessages = std::unordered_map<std::string, std::vector<std::string>>;
+
+/**
+ * @brief This function parses lazy_listener_handles, i.e., [{name: "...", messages: ["...", ...]}, ...], into the
+ *        listen node messages of each lazy handler by its name
+ *
+ * @param t_param     [in] value of the parameter
+ * @param t_messages  [out] listen node messages by handler name, malformed entries are left out
+ * @param t_malformed [out] indices of the malformed entries, i.e., not a struct, no name, or no non-empty list of
+ *                    string messages
+ * @return false if t_param is not a list, in which case nothing is parsed
+ */
+inline bool parse_lazy_handles(XmlRpc::XmlRpcValue& t_param, LazyMessages& t_messages, std::vector<int>& t_malformed) {
+  using XmlRpc::XmlRpcValue;
+  if (t_param.getType() != XmlRpcValue::TypeArray) {
+    return false;
+  }
+
+  for (int i = 0; i < t_param.size(); ++i) {
+    auto& entry = t_param[i];
+    if (entry.getType() != XmlRpcValue::TypeStruct or not entry.hasMember("name") or not entry.hasMember("messages") or
+        entry["name"].getType() != XmlRpcValue::TypeString or entry["messages"].getType() != XmlRpcValue::TypeArray or
+        entry["messages"].size() == 0) {
+      t_malformed.push_back(i);
+      continue;
+    }
+
+    std::vector<std::string> messages;
+    auto& message_list = entry["messages"];
+    for (int j = 0; j < message_list.size() and message_list[j].getType() == XmlRpcValue::TypeString; ++j) {
+      messages.push_back(static_cast<std::string&>(message_list[j]));
+    }
+
+    if (messages.size() != static_cast<std::size_t>(message_list.size())) {
+      t_malformed.push_back(i);  // a handler indexed by part of its messages would miss the rest
+      continue;
+    }
+
+    t_messages[static_cast<std::string&>(entry["name"])] = std::move(messages);
+  }
+
+  return true;
+}
+
+/**
+ * @brief Handlers listed in listener_handles, in the order they are loaded. Lazy handlers are indexed by the messages
+ *        given in lazy_listener_handles, and created only the first time one of those messages is looked up, see
+ *        find. A handler that fails to be created is skipped, and not tried again.
+ *
+ * @tparam Handler  shared pointer to ListenerHandle, or anything that provides listen_node_messages()
+ */
+template <typename Handler>
+class HandlerSlots {
+ public:
+  struct Slot {
+    std::string name_;
+    Handler handler_{}; /*!< nullptr until created */
+    bool failed_ = false;
+  };
+
+ private:
+  std::vector<Slot> slots_;
+  HandlerIndex index_;
+
+ public:
+  /**
+   * @brief This function appends the handlers, those not in t_lazy are created immediately
+   *
+   * @param t_create  callable with signature Handler(std::string const&), returns nullptr if the handler fails to be
+   *                  created
+   * @return number of handlers created
+   */
+  template <typename Create>
+  std::size_t load(std::vector<std::string> const& t_names, LazyMessages const& t_lazy, Create&& t_create) {
+    std::size_t ret_val = 0;
+    this->slots_.reserve(this->slots_.size() + t_names.size());
+    for (auto const& name : t_names) {
+      this->slots_.push_back(Slot{name, nullptr, false});
+
+      auto const lazy = t_lazy.find(name);
+      if (lazy != t_lazy.end()) {
+        this->index_.add(lazy->second);
+      } else if (this->create(this->slots_.size() - 1, t_create)) {
+        this->index_.add(this->slots_.back().handler_->listen_node_messages());
+        ++ret_val;
+      } else {
+        this->index_.add({});  // keeps the index aligned, the slot is skipped since it failed
+      }
+    }
+
+    return ret_val;
+  }
+
+  /**
+   * @brief This function creates the handler of slot t_index, unless it is created already, or failed before
+   *
+   * @return true if the handler is available
+   */
+  template <typename Create>
+  bool create(std::size_t const t_index, Create&& t_create) {
+    auto& slot = this->slots_[t_index];
+    if (not slot.handler_ and not slot.failed_) {
+      slot.handler_ = t_create(slot.name_);
+      slot.failed_  = not slot.handler_;
+    }
+
+    return not slot.failed_;
+  }
+
+  /**
+   * @brief This function returns the first candidate for t_message whose handler can be created, and satisfies t_pred,
+   *        see HandlerIndex::find
+   *
+   * @param t_pred  callable with signature bool(Handler const&)
+   * @return index of the handler, HandlerIndex::NOT_FOUND if none satisfies t_pred
+   */
+  template <typename Create, typename Pred>
+  std::size_t find(std::string const& t_message, Create&& t_create, Pred t_pred) {
+    return this->index_.find(t_message, [this, &t_create, &t_pred](std::size_t const t_index) {
+      return this->create(t_index, t_create) and t_pred(this->slots_[t_index].handler_);
+    });
+  }
+
+  /**
+   * @brief This function returns number of lazy handlers that are not created yet
+   */
+  std::size_t deferred_count() const noexcept {
+    std::size_t ret_val = 0;
+    for (auto const& slot : this->slots_) {
+      ret_val += slot.handler_ or slot.failed_ ? 0 : 1;
+    }
+
+    return ret_val;
+  }
+
+  Slot const& operator[](std::size_t const t_index) const noexcept { return this->slots_[t_index]; }
+
+  auto begin() const noexcept { return this->slots_.begin(); }
+
+  auto end() const noexcept { return this->slots_.end(); }
+
+  std::size_t size() const noexcept { return this->slots_.size(); }
+};
+
+}  // namespace detail
+}  // namespace tm_robot_listener
+
+#endif
@@ -0,0 +1,124 @@
+#ifndef TMR_LATENCY_HISTOGRAM_HPP_
+#define TMR_LATENCY_HISTOGRAM_HPP_
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace tm_robot_listener {
+namespace detail {
+
+/**
+ * @brief Histogram of latencies with log-linear buckets, the same layout as HdrHistogram: every power of 2 range is
+ *        split into SUB_BUCKET_COUNT buckets of equal width, therefore the relative error of every value reported is
+ *        at most 1 / SUB_BUCKET_COUNT, whatever its magnitude. Recording is a few bit operations, nothing is allocated.
+ *
+ * @note  Latencies are kept in nanoseconds, the ones longer than 2^(MAX_MAGNITUDE + 1) ns (about 73 minutes) are
+ *        clamped
+ */
+class LatencyHistogram {
+ public:
+  static constexpr unsigned SUB_BUCKET_BITS       = 5;
+  static constexpr std::uint64_t SUB_BUCKET_COUNT = std::uint64_t{1} << SUB_BUCKET_BITS;
+  static constexpr unsigned MAX_MAGNITUDE         = 41;
+  static constexpr std::size_t BUCKET_COUNT       = (MAX_MAGNITUDE - SUB_BUCKET_BITS + 2) * SUB_BUCKET_COUNT;
+
+ private:
+  std::array<std::uint64_t, BUCKET_COUNT> counts_{};
+  std::uint64_t total_count_ = 0;
+  std::uint64_t max_         = 0;
+  std::uint64_t sum_         = 0;
+
+  /**
+   * @brief This function returns the bucket of t_value, values below 2 * SUB_BUCKET_COUNT have a bucket of their own
+   */
+  static std::size_t bucket_of(std::uint64_t const t_value) noexcept {
+    if (t_value < SUB_BUCKET_COUNT) {
+      return static_cast<std::size_t>(t_value);
+    }
+
+    auto const magnitude = 63U - static_cast<unsigned>(__builtin_clzll(t_value));
+    auto const shift     = magnitude - SUB_BUCKET_BITS;
+    return (shift + 1) * SUB_BUCKET_COUNT + (t_value >> shift) - SUB_BUCKET_COUNT;
+  }
+
+  /**
+   * @brief This function returns the largest value that falls into t_bucket
+   */
+  static std::uint64_t highest_of(std::size_t const t_bucket) noexcept {
+    if (t_bucket < 2 * SUB_BUCKET_COUNT) {
+      return t_bucket;
+    }
+
+    auto const shift = t_bucket / SUB_BUCKET_COUNT - 1;
+    auto const lower = (t_bucket % SUB_BUCKET_COUNT + SUB_BUCKET_COUNT) << shift;
+    return lower + (std::uint64_t{1} << shift) - 1;
+  }
+
+ public:
+  static constexpr std::uint64_t MAX_VALUE = (std::uint64_t{1} << (MAX_MAGNITUDE + 1)) - 1;
+
+  void record(std::chrono::nanoseconds const t_latency) noexcept {
+    auto const count = static_cast<std::uint64_t>(std::max<std::int64_t>(t_latency.count(), 0));
+    auto const value = count > MAX_VALUE ? MAX_VALUE : count;
+    ++this->counts_[bucket_of(value)];
+    ++this->total_count_;
+    this->max_ = std::max(this->max_, value);
+    this->sum_ += value;
+  }
+
+  /**
+   * @brief This function returns the latency that t_ratio of the recorded latencies are no longer than, e.g., 0.99 for
+   *        the 99th percentile
+   *
+   * @return zero if nothing is recorded
+   */
+  std::chrono::nanoseconds percentile(double const t_ratio) const noexcept {
+    if (this->total_count_ == 0) {
+      return std::chrono::nanoseconds::zero();
+    }
+
+    auto const total = static_cast<double>(this->total_count_);
+    auto const rank  = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::min(t_ratio, 1.0) * total + 0.5));
+
+    std::uint64_t seen = 0;
+    for (std::size_t bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+      seen += this->counts_[bucket];
+      if (seen >= rank) {
+        return std::chrono::nanoseconds{std::min(highest_of(bucket), this->max_)};
+      }
+    }
+
+    return this->max();
+  }
+
+  std::chrono::nanoseconds max() const noexcept { return std::chrono::nanoseconds{this->max_}; }
+
+  std::chrono::nanoseconds mean() const noexcept {
+    return std::chrono::nanoseconds{this->total_count_ == 0 ? 0 : this->sum_ / this->total_count_};
+  }
+
+  std::uint64_t count() const noexcept { return this->total_count_; }
+
+  /**
+   * @brief This function adds every latency recorded by t_other, as if they were recorded by this histogram
+   */
+  void merge(LatencyHistogram const& t_other) noexcept {
+    for (std::size_t bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+      this->counts_[bucket] += t_other.counts_[bucket];
+    }
+
+    this->total_count_ += t_other.total_count_;
+    this->max_ = std::max(this->max_, t_other.max_);
+    this->sum_ += t_other.sum_;
+  }
+
+  void reset() noexcept { *this = LatencyHistogram{}; }
+};
+
+}  // namespace detail
+}  // namespace tm_robot_listener
+
+#endif
@@ -1,15 +1,64 @@
 #ifndef TMR_MSG_GEN_HPP_
 #define TMR_MSG_GEN_HPP_
 
-#include <boost/format.hpp>
 #include <boost/fusion/include/at_key.hpp>
 #include <boost/shared_ptr.hpp>
-#include <numeric>
+#include <boost/utility/string_ref.hpp>
+#include <cstring>
 #include <string>
 #include <unordered_set>
 
+#include "tmr_object_pool.hpp"
+
 namespace tm_robot_listener {
 namespace motion_function {
+namespace detail {
+
+/**
+ * @brief This function calculates xor of the bytes in [t_begin, t_end)
+ */
+inline unsigned char xor_checksum(char const* t_begin, char const* const t_end) noexcept {
+  unsigned char ret_val = 0;
+  for (; t_begin != t_end; ++t_begin) {
+    ret_val ^= static_cast<unsigned char>(*t_begin);
+  }
+
+  return ret_val;
+}
+
+/**
+ * @brief This function appends t_byte in two digits hexadecimal form without "0x", e.g. 0x0A -> "0A"
+ */
+inline void append_hex_byte(std::string& t_out, unsigned char const t_byte) noexcept {
+  constexpr char HEX_DIGITS[] = "0123456789ABCDEF";
+  t_out.push_back(HEX_DIGITS[t_byte >> 4U]);
+  t_out.push_back(HEX_DIGITS[t_byte & 0x0FU]);
+}
+
+/**
+ * @brief This function returns number of digits of t_value in decimal form
+ */
+constexpr std::size_t decimal_width(std::size_t const t_value) noexcept {
+  return t_value < 10 ? 1 : 1 + decimal_width(t_value / 10);
+}
+
+/**
+ * @brief This function appends t_value in decimal form, and returns xor of the appended digits
+ */
+inline unsigned char append_decimal(std::string& t_out, std::size_t t_value) noexcept {
+  char digits[20];
+  auto const end = std::end(digits);
+  auto begin     = end;
+  do {
+    *--begin = static_cast<char>('0' + t_value % 10);
+    t_value /= 10;
+  } while (t_value != 0);
+
+  t_out.append(begin, end);
+  return xor_checksum(begin, end);
+}
+
+}  // namespace detail
 
 /**
  * @brief calculate xor checksum
@@ -20,7 +69,9 @@ namespace motion_function {
  * @note  The input string should contain "$"
  */
 inline auto calculate_checksum(std::string const& t_data) noexcept {
-  return (boost::format("%02X") % std::accumulate(std::next(t_data.begin()), t_data.end(), 0, std::bit_xor<>{})).str();
+  std::string ret_val;
+  detail::append_hex_byte(ret_val, t_data.empty() ? 0 : detail::xor_checksum(&t_data[1], &t_data[0] + t_data.size()));
+  return ret_val;
 }
 
 /**
@@ -36,9 +87,27 @@ struct BaseHeaderProduct {
   BaseHeaderProduct& operator=(const BaseHeaderProduct& /*unused*/) = default;
   BaseHeaderProduct& operator=(BaseHeaderProduct&&) /*unused*/ = default;
 
-  virtual bool empty() const noexcept           = 0;
-  virtual std::string to_str() const noexcept   = 0;
-  virtual bool has_script_exit() const noexcept = 0;
+  virtual bool empty() const noexcept                       = 0;
+  virtual std::string to_str() const noexcept               = 0;
+  virtual void serialize(std::string& t_out) const noexcept = 0;
+  virtual bool has_script_exit() const noexcept             = 0;
+
+  /**
+   * @brief This function returns the header of the command, e.g. "$TMSCT", empty if the command list is empty
+   */
+  virtual boost::string_ref header() const noexcept = 0;
+
+  /**
+   * @brief This function returns the item TM robot echoes back in the response, i.e., ID for TMSCT, and sub command
+   *        for TMSTA. The returned view is valid as long as the product is alive.
+   */
+  virtual boost::string_ref response_key() const noexcept = 0;
+
+  /**
+   * @brief This function returns the complete frame if it is rendered in advance, so that it can be sent without
+   *        serializing, see PrebuiltHeaderProduct. Empty by default.
+   */
+  virtual boost::string_ref prebuilt_frame() const noexcept { return {}; }
 
   virtual ~BaseHeaderProduct() = default;
 };
@@ -52,11 +121,57 @@ template <typename Tag>
 class HeaderProduct final : public BaseHeaderProduct {
  private:
   friend class HeaderProductBuilder<Tag>;
+  friend class PreparedScript<Tag>;
+  template <typename T, std::size_t Capacity>
+  friend class ::tm_robot_listener::detail::SharedObjectPool;
+
+  static constexpr std::size_t MAX_RETAINED_CAPACITY = 1U << 16U; /*!< larger payload buffer is freed on clear */
 
   bool scriptExit_ = false;
   bool ended_      = false;
 
-  std::vector<std::string> list;
+  std::string payload_;            /*!< data section, commands are delimited as soon as they are appended */
+  std::size_t command_count_ = 0;  /*!< number of items (including ID) in payload_ */
+  unsigned char payload_xor_ = 0;  /*!< xor of payload_, updated as commands are appended */
+
+  /**
+   * @brief This function resets the product for reuse, the payload buffer is kept unless it is too large
+   */
+  void clear() noexcept {
+    this->scriptExit_    = false;
+    this->ended_         = false;
+    this->command_count_ = 0;
+    this->payload_xor_   = 0;
+    if (this->payload_.capacity() > MAX_RETAINED_CAPACITY) {
+      std::string{}.swap(this->payload_);
+    } else {
+      this->payload_.clear();
+    }
+  }
+
+  void append(char const* const t_data, std::size_t const t_size) noexcept {
+    this->append_with([=](std::string& t_out) { t_out.append(t_data, t_size); });
+  }
+
+  /**
+   * @brief This function appends a command written in place by t_writer, i.e., void(std::string&), which must only
+   *        append to the string passed
+   */
+  template <typename Writer>
+  void append_with(Writer const& t_writer) noexcept {
+    if (this->command_count_ != 0) {
+      auto const delimiter = detail::command_delimiter<Tag>(this->command_count_);
+      auto const size      = std::strlen(delimiter);
+      this->payload_.append(delimiter, size);
+      this->payload_xor_ ^= detail::xor_checksum(delimiter, delimiter + size);
+    }
+
+    auto const begin = this->payload_.size();
+    t_writer(this->payload_);
+    auto const data = this->payload_.data();
+    this->payload_xor_ ^= detail::xor_checksum(data + begin, data + this->payload_.size());
+    ++this->command_count_;
+  }
 
  public:
   /**
@@ -65,7 +180,7 @@ class HeaderProduct final : public BaseHeaderProduct {
    * @return true   Command list is empty
    * @return false  Command list is not empty
    */
-  bool empty() const noexcept override { return this->list.empty(); }
+  bool empty() const noexcept override { return this->command_count_ == 0; }
 
   /**
    * @brief This function converts appended commands to string to send to TM listen node server
@@ -77,11 +192,34 @@ class HeaderProduct final : public BaseHeaderProduct {
    * @note Error > Warning for TMSCT, even warning and error happened at the same time, TMSCT only returns ERROR line
    */
   std::string to_str() const noexcept override {
-    auto const data_str = detail::assemble_to_msg<Tag>(this->list);
-    auto const length   = data_str.size();
-    auto const result   = (boost::format("%s,%d,%s,") % Tag::HEADER() % length % data_str).str();
+    std::string result;
+    this->serialize(result);
+    return result;
+  }
+
+  /**
+   * @brief This function appends "$HEADER,LENGTH,DATA,*CS\r\n" to t_out in a single pass, t_out is resized at most
+   *        once. Since the checksum of the data section is accumulated while appending commands, only the header and
+   *        the length are xor-ed here.
+   *
+   * @param t_out buffer to append to, existing content is kept
+   */
+  void serialize(std::string& t_out) const noexcept override {
+    auto const header_size = std::strlen(Tag::HEADER());
+    auto const length      = this->payload_.size();
+    t_out.reserve(t_out.size() + header_size + detail::decimal_width(length) + length + sizeof(",,,*XX\r\n"));
 
-    return result + "*" + calculate_checksum(result) + "\r\n";
+    t_out.append(Tag::HEADER(), header_size).push_back(',');
+    auto checksum = detail::xor_checksum(Tag::HEADER() + 1, Tag::HEADER() + header_size);
+    checksum ^= detail::append_decimal(t_out, length);
+    t_out.push_back(',');
+    t_out.append(this->payload_).push_back(',');
+    checksum ^= this->payload_xor_;
+    checksum ^= ',';  // xor of the three commas around length and data section
+
+    t_out.push_back('*');
+    detail::append_hex_byte(t_out, checksum);
+    t_out.append("\r\n", 2);
   }
 
   /**
@@ -91,6 +229,13 @@ class HeaderProduct final : public BaseHeaderProduct {
    * @return false
    */
   bool has_script_exit() const noexcept override { return this->scriptExit_; }
+
+  boost::string_ref header() const noexcept override { return Tag::HEADER(); }
+
+  boost::string_ref response_key() const noexcept override {
+    boost::string_ref const payload{this->payload_};
+    return payload.substr(0, payload.find(','));
+  }
 };
 
 /**
@@ -102,7 +247,52 @@ template <>
 struct HeaderProduct<void> final : public BaseHeaderProduct {
   bool empty() const noexcept override { return true; }
   std::string to_str() const noexcept override { return ""; }
+  void serialize(std::string& /*unused*/) const noexcept override {}
   bool has_script_exit() const noexcept override { return false; }
+  boost::string_ref header() const noexcept override { return {}; }
+  boost::string_ref response_key() const noexcept override { return {}; }
+};
+
+/**
+ * @brief Command list that is rendered once, including length and checksum, and sent as is afterwards, see
+ *        cached_frame
+ */
+class PrebuiltHeaderProduct final : public BaseHeaderProduct {
+ private:
+  std::string frame_;
+  std::string header_;
+  std::string response_key_;
+  bool script_exit_;
+
+ public:
+  explicit PrebuiltHeaderProduct(BaseHeaderProduct const& t_product)
+    : frame_{t_product.to_str()},
+      header_{t_product.header().to_string()},
+      response_key_{t_product.response_key().to_string()},
+      script_exit_{t_product.has_script_exit()} {}
+
+  /**
+   * @brief Construct from a frame rendered elsewhere, see raw_frame
+   *
+   * @param t_frame         complete frame, including length, checksum, and the trailing "\r\n"
+   * @param t_header        header of the frame, e.g. "$TMSCT"
+   * @param t_response_key  see BaseHeaderProduct::response_key
+   * @param t_script_exit   whether the frame contains ScriptExit()
+   */
+  PrebuiltHeaderProduct(std::string t_frame, std::string t_header, std::string t_response_key,
+                        bool const t_script_exit) noexcept
+    : frame_{std::move(t_frame)},
+      header_{std::move(t_header)},
+      response_key_{std::move(t_response_key)},
+      script_exit_{t_script_exit} {}
+
+  bool empty() const noexcept override { return this->frame_.empty(); }
+  std::string to_str() const noexcept override { return this->frame_; }
+  void serialize(std::string& t_out) const noexcept override { t_out.append(this->frame_); }
+  bool has_script_exit() const noexcept override { return this->script_exit_; }
+  boost::string_ref header() const noexcept override { return this->header_; }
+  boost::string_ref response_key() const noexcept override { return this->response_key_; }
+  boost::string_ref prebuilt_frame() const noexcept override { return this->frame_; }
 };
 
 /**
@@ -113,16 +303,34 @@ struct HeaderProduct<void> final : public BaseHeaderProduct {
 template <typename Tag>
 class HeaderProductBuilder {
  private:
-  HeaderProduct<Tag> result_;
+  static constexpr std::size_t POOL_CAPACITY = 16; /*!< products in use at once that are recycled */
+  using ProductPool = ::tm_robot_listener::detail::SharedObjectPool<HeaderProduct<Tag>, POOL_CAPACITY>;
+
+  boost::shared_ptr<HeaderProduct<Tag>> result_; /*!< recycled product, handed over by End or ScriptExit */
 
   friend class Header<Tag>;
-  HeaderProductBuilder() = default;
+  HeaderProductBuilder() : result_{ProductPool::instance().acquire()} {}
 
-  // temp
-  void append_command(Command<Tag> const& t_cmd) noexcept { this->result_.list.push_back(t_cmd.get_cmd()); }
-  void append_str(std::string const& t_str) noexcept { this->result_.list.push_back(t_str); }
+  /**
+   * @brief This function returns the product being built, a new one if the previous one is handed over already
+   */
+  HeaderProduct<Tag>& product() {
+    if (not this->result_) {
+      this->result_ = ProductPool::instance().acquire();
+    }
+
+    return *this->result_;
+  }
+
+  void append_command(Command<Tag> const& t_cmd) noexcept { this->append_str(t_cmd.name); }
+  void append_str(std::string const& t_str) noexcept { this->product().append(t_str.data(), t_str.size()); }
 
  public:
+  HeaderProductBuilder(HeaderProductBuilder const&) = delete;  // builders would share the product
+  HeaderProductBuilder(HeaderProductBuilder&&)      = default;
+  HeaderProductBuilder& operator=(HeaderProductBuilder const&) = delete;
+  HeaderProductBuilder& operator=(HeaderProductBuilder&&) = default;
+
   /**
    * @brief operator<< for implementation of fluent interface
    *
@@ -139,7 +347,7 @@ class HeaderProductBuilder {
   decltype(auto) operator<<(Command<CommandTag> const& t_cmd) noexcept {
     static_assert(std::is_same<CommandTag, motion_function::detail::TMSCTTag>::value,
                   "Only TMSCT can have multiple commands in one script");
-    if (not this->result_.ended_ and not this->result_.scriptExit_) {
+    if (not this->product().ended_ and not this->product().scriptExit_) {
       this->append_command(t_cmd);
     }
 
@@ -147,20 +355,21 @@ class HeaderProductBuilder {
   }
 
   /**
-   * @brief
+   * @brief operator<< for implementation of fluent interface, the expression is rendered directly into the script
    *
    * @tparam T
-   * @param t_var
+   * @param t_expr Expression to append
    * @return decltype(auto)
    *
    * @todo unordered_set need to have state across header product builder
    */
-  template <typename T>
-  decltype(auto) operator<<(Expression<T> const& t_expr) {
+  template <typename T, typename Node>
+  decltype(auto) operator<<(Expression<T, Node> const& t_expr) {
     static_assert(std::is_same<Tag, motion_function::detail::TMSCTTag>::value, "Only TMSCT can declare variable");
 
-    if (not this->result_.ended_ and not this->result_.scriptExit_) {
-      this->append_str(t_expr.value);
+    auto& product = this->product();
+    if (not product.ended_ and not product.scriptExit_) {
+      product.append_with([&t_expr](std::string& t_out) { t_expr.render(t_out); });
     }
 
     return *this;
@@ -170,25 +379,26 @@ class HeaderProductBuilder {
    * @brief operator<< for implementation of fluent interface
    *
    * @param t_exit  ScriptExit instance, the struct is merely used for tag dispatch
-   * @return share pointer of the result
+   * @return share pointer of the result, the product is moved out of the builder
    */
   auto operator<<(ScriptExit const& /*unused*/) noexcept {
     static_assert(std::is_same<Tag, detail::TMSCTTag>::value, "ScriptExit() can only be called in TMSCT");
 
-    this->result_.list.emplace_back("ScriptExit()");
-    this->result_.scriptExit_ = true;
-    return boost::make_shared<HeaderProduct<Tag>>(this->result_);
+    constexpr char SCRIPT_EXIT[] = "ScriptExit()";
+    this->product().append(SCRIPT_EXIT, sizeof(SCRIPT_EXIT) - 1);
+    this->product().scriptExit_ = true;
+    return std::move(this->result_);
   }
 
   /**
    * @brief operator<< for implementation of fluent interface
    *
    * @param t_end  End instance, the struct is merely used for tag dispatch
-   * @return share pointer of the result
+   * @return share pointer of the result, the product is moved out of the builder
    */
   auto operator<<(End const& /*unused*/) noexcept {
-    this->result_.ended_ = true;
-    return boost::make_shared<HeaderProduct<Tag>>(this->result_);
+    this->product().ended_ = true;
+    return std::move(this->result_);
   }
 };
 
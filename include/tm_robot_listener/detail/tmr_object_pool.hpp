@@ -0,0 +1,69 @@
+#ifndef TMR_OBJECT_POOL_HPP_
+#define TMR_OBJECT_POOL_HPP_
+
+#include <boost/make_shared.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+
+namespace tm_robot_listener {
+namespace detail {
+
+/**
+ * @brief Pool of shared objects that are recycled once every user drops them, the pool keeps one reference to each
+ *        object, therefore an object is free again when the pool holds the only reference. Recycling costs neither the
+ *        object nor the control block of the shared pointer, and T::clear() may keep the buffers T owns.
+ *
+ * @tparam T        default constructible, T::clear() resets the object to its default state
+ * @tparam Capacity number of objects recycled, more objects in use at once are allocated as usual
+ *
+ * @note  acquire can be called from any thread, the objects can be dropped by any thread
+ */
+template <typename T, std::size_t Capacity>
+class SharedObjectPool {
+ private:
+  std::mutex mutex_;
+  std::array<boost::shared_ptr<T>, Capacity> slots_; /*!< filled in order, free objects are reused first */
+
+ public:
+  /**
+   * @brief This function returns the pool shared by the whole process
+   */
+  static SharedObjectPool& instance() noexcept {
+    static SharedObjectPool pool;
+    return pool;
+  }
+
+  /**
+   * @brief This function returns a cleared object, which is not referenced by anyone else
+   */
+  boost::shared_ptr<T> acquire() {
+    {
+      std::lock_guard<std::mutex> const lock{this->mutex_};
+      for (auto& slot : this->slots_) {
+        if (slot and slot.use_count() != 1) {
+          continue;
+        }
+
+        if (not slot) {
+          slot = boost::make_shared<T>();
+        } else {
+          std::atomic_thread_fence(std::memory_order_acquire);  // pairs with the release of the last user
+          slot->clear();
+        }
+
+        return slot;
+      }
+    }
+
+    return boost::make_shared<T>();
+  }
+};
+
+}  // namespace detail
+}  // namespace tm_robot_listener
+
+#endif
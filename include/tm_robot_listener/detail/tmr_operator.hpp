@@ -2,114 +2,221 @@
 #define TMR_OPERATOR_HPP_
 
 #include "tmr_fwd.hpp"
+#include "tmr_mt_helper.hpp"
+#include "tmr_stringifier.hpp"
 
-#include <boost/xpressive/xpressive.hpp>
 #include <string>
+#include <type_traits>
+#include <utility>
 
-// @todo some expression doesn't accept r-value
 #define TM_UNARY_OP_IS_POSTFIX_0
 #define TM_UNARY_OP_IS_POSTFIX_1 , int
 
 #define TM_UNARY_OP_APPLY_POSTFIX_0(VAL, tok) tok VAL
 #define TM_UNARY_OP_APPLY_POSTFIX_1(VAL, tok) VAL tok
 
-#define TM_UNARY_OP_COMBINE_POSTFIX_0(VAL, tok) (#tok + VAL())
-#define TM_UNARY_OP_COMBINE_POSTFIX_1(VAL, tok) (VAL() + #tok)
-
-#define TM_DEFINE_UNARY_OPERATOR(CLASS, tok, POST)                                                            \
-  template <typename T>                                                                                       \
-  [[gnu::warn_unused_result]] auto operator tok(CLASS<T> const& t_e TM_UNARY_OP_IS_POSTFIX_##POST) noexcept { \
-    auto const op_ret_type = []() {                                                                           \
-      T a{};                                                                                                  \
-      return TM_UNARY_OP_APPLY_POSTFIX_##POST(a, tok);                                                        \
-    };                                                                                                        \
-    return Expression<decltype(op_ret_type())>{'(' + TM_UNARY_OP_COMBINE_POSTFIX_##POST(t_e, tok) + ')'};     \
+#define TM_DEFINE_UNARY_OPERATOR(tok, POST)                                                                         \
+  template <typename E, std::enable_if_t<detail::is_statement<E>, bool> = true>                                     \
+  [[gnu::warn_unused_result]] auto operator tok(E const& t_e TM_UNARY_OP_IS_POSTFIX_##POST) noexcept {              \
+    using result_t = std::decay_t<decltype(                                                                         \
+      TM_UNARY_OP_APPLY_POSTFIX_##POST(std::declval<typename detail::RealType<E>::type&>(), tok))>;                 \
+    using node_t = detail::UnaryNode<detail::operand_t<E>, POST == 1>;                                              \
+    return Expression<result_t, node_t>{node_t{#tok, detail::make_operand(t_e)}};                                   \
   }
 
-#define TM_DEFINE_BINARY_OPERATOR(CLASS, tok)                                                         \
-  template <typename T, typename U>                                                                   \
-  [[gnu::warn_unused_result]] auto operator tok(CLASS<T> const& t_e, U const& t_u) noexcept {         \
-    using stringifier = std::conditional_t<detail::is_expression<U> or detail::is_named_var<U>,       \
-                                           detail::statement_to_string, value_to_string<U>>;          \
-                                                                                                      \
-    auto const op_ret_type = []() {                                                                   \
-      T a{};                                                                                          \
-      typename detail::RealType<U>::type b{};                                                         \
-      return a tok b;                                                                                 \
-    };                                                                                                \
-    return Expression<decltype(op_ret_type())>{'(' + t_e() + #tok + stringifier{}(t_u) + ')'};        \
-  }                                                                                                   \
-                                                                                                      \
-  template <typename T, typename U,                                                                   \
-            std::enable_if_t<!(detail::is_expression<U> or detail::is_named_var<U>), bool> = true>    \
-  [[gnu::warn_unused_result]] auto operator tok(U const& t_u, CLASS<T> const& t_e) noexcept {         \
-    auto const op_ret_type = []() {                                                                   \
-      T a{};                                                                                          \
-      U b{};                                                                                          \
-      return b tok a;                                                                                 \
-    };                                                                                                \
-    return Expression<decltype(op_ret_type())>{'(' + value_to_string<U>{}(t_u) + #tok + t_e() + ')'}; \
+#define TM_DEFINE_BINARY_OPERATOR(tok)                                                                              \
+  template <typename L, typename R, std::enable_if_t<detail::is_statement<L>, bool> = true>                         \
+  [[gnu::warn_unused_result]] auto operator tok(L const& t_l, R const& t_r) noexcept {                              \
+    using result_t = std::decay_t<decltype(std::declval<typename detail::RealType<L>::type&>()                      \
+                                             tok std::declval<typename detail::RealType<R>::type&>())>;            \
+    using node_t = detail::BinaryNode<detail::operand_t<L>, detail::operand_t<R>>;                                  \
+    return Expression<result_t, node_t>{node_t{#tok, detail::make_operand(t_l), detail::make_operand(t_r)}};        \
+  }                                                                                                                 \
+                                                                                                                    \
+  template <typename L, typename R,                                                                                 \
+            std::enable_if_t<not detail::is_statement<L> and detail::is_statement<R>, bool> = true>                 \
+  [[gnu::warn_unused_result]] auto operator tok(L const& t_l, R const& t_r) noexcept {                              \
+    using result_t =                                                                                                \
+      std::decay_t<decltype(std::declval<L&>() tok std::declval<typename detail::RealType<R>::type&>())>;           \
+    using node_t = detail::BinaryNode<detail::operand_t<L>, detail::operand_t<R>>;                                  \
+    return Expression<result_t, node_t>{node_t{#tok, detail::make_operand(t_l), detail::make_operand(t_r)}};        \
   }
 
-#define TM_DEFINE_OPERATORS(CLASS)       \
-  TM_DEFINE_UNARY_OPERATOR(CLASS, ++, 1) \
-  TM_DEFINE_UNARY_OPERATOR(CLASS, --, 1) \
-  TM_DEFINE_UNARY_OPERATOR(CLASS, ++, 0) \
-  TM_DEFINE_UNARY_OPERATOR(CLASS, --, 0) \
-  TM_DEFINE_UNARY_OPERATOR(CLASS, +, 0)  \
-  TM_DEFINE_UNARY_OPERATOR(CLASS, -, 0)  \
-  TM_DEFINE_UNARY_OPERATOR(CLASS, ~, 0)  \
-  TM_DEFINE_UNARY_OPERATOR(CLASS, !, 0)  \
-  TM_DEFINE_BINARY_OPERATOR(CLASS, *)    \
-  TM_DEFINE_BINARY_OPERATOR(CLASS, /)    \
-  TM_DEFINE_BINARY_OPERATOR(CLASS, %)    \
-  TM_DEFINE_BINARY_OPERATOR(CLASS, +)    \
-  TM_DEFINE_BINARY_OPERATOR(CLASS, -)    \
-  TM_DEFINE_BINARY_OPERATOR(CLASS, <<)   \
-  TM_DEFINE_BINARY_OPERATOR(CLASS, >>)   \
-  TM_DEFINE_BINARY_OPERATOR(CLASS, >)    \
-  TM_DEFINE_BINARY_OPERATOR(CLASS, >=)   \
-  TM_DEFINE_BINARY_OPERATOR(CLASS, <)    \
-  TM_DEFINE_BINARY_OPERATOR(CLASS, <=)   \
-  TM_DEFINE_BINARY_OPERATOR(CLASS, ==)   \
-  TM_DEFINE_BINARY_OPERATOR(CLASS, !=)   \
-  TM_DEFINE_BINARY_OPERATOR(CLASS, &)    \
-  TM_DEFINE_BINARY_OPERATOR(CLASS, ^)    \
-  TM_DEFINE_BINARY_OPERATOR(CLASS, |)    \
-  TM_DEFINE_BINARY_OPERATOR(CLASS, &&)   \
-  TM_DEFINE_BINARY_OPERATOR(CLASS, ||)   \
-  TM_DEFINE_BINARY_OPERATOR(CLASS, +=)   \
-  TM_DEFINE_BINARY_OPERATOR(CLASS, -=)   \
-  TM_DEFINE_BINARY_OPERATOR(CLASS, *=)   \
-  TM_DEFINE_BINARY_OPERATOR(CLASS, /=)   \
-  TM_DEFINE_BINARY_OPERATOR(CLASS, %=)   \
-  TM_DEFINE_BINARY_OPERATOR(CLASS, <<=)  \
-  TM_DEFINE_BINARY_OPERATOR(CLASS, >>=)  \
-  TM_DEFINE_BINARY_OPERATOR(CLASS, &=)   \
-  TM_DEFINE_BINARY_OPERATOR(CLASS, ^=)   \
-  TM_DEFINE_BINARY_OPERATOR(CLASS, |=)
+/**
+ * @brief Operators of Variable and Expression, the operands are kept in a typed tree, which is rendered only once, see
+ *        Expression
+ */
+#define TM_DEFINE_OPERATORS()       \
+  TM_DEFINE_UNARY_OPERATOR(++, 1) \
+  TM_DEFINE_UNARY_OPERATOR(--, 1) \
+  TM_DEFINE_UNARY_OPERATOR(++, 0) \
+  TM_DEFINE_UNARY_OPERATOR(--, 0) \
+  TM_DEFINE_UNARY_OPERATOR(+, 0)  \
+  TM_DEFINE_UNARY_OPERATOR(-, 0)  \
+  TM_DEFINE_UNARY_OPERATOR(~, 0)  \
+  TM_DEFINE_UNARY_OPERATOR(!, 0)  \
+  TM_DEFINE_BINARY_OPERATOR(*)    \
+  TM_DEFINE_BINARY_OPERATOR(/)    \
+  TM_DEFINE_BINARY_OPERATOR(%)    \
+  TM_DEFINE_BINARY_OPERATOR(+)    \
+  TM_DEFINE_BINARY_OPERATOR(-)    \
+  TM_DEFINE_BINARY_OPERATOR(<<)   \
+  TM_DEFINE_BINARY_OPERATOR(>>)   \
+  TM_DEFINE_BINARY_OPERATOR(>)    \
+  TM_DEFINE_BINARY_OPERATOR(>=)   \
+  TM_DEFINE_BINARY_OPERATOR(<)    \
+  TM_DEFINE_BINARY_OPERATOR(<=)   \
+  TM_DEFINE_BINARY_OPERATOR(==)   \
+  TM_DEFINE_BINARY_OPERATOR(!=)   \
+  TM_DEFINE_BINARY_OPERATOR(&)    \
+  TM_DEFINE_BINARY_OPERATOR(^)    \
+  TM_DEFINE_BINARY_OPERATOR(|)    \
+  TM_DEFINE_BINARY_OPERATOR(&&)   \
+  TM_DEFINE_BINARY_OPERATOR(||)   \
+  TM_DEFINE_BINARY_OPERATOR(+=)   \
+  TM_DEFINE_BINARY_OPERATOR(-=)   \
+  TM_DEFINE_BINARY_OPERATOR(*=)   \
+  TM_DEFINE_BINARY_OPERATOR(/=)   \
+  TM_DEFINE_BINARY_OPERATOR(%=)   \
+  TM_DEFINE_BINARY_OPERATOR(<<=)  \
+  TM_DEFINE_BINARY_OPERATOR(>>=)  \
+  TM_DEFINE_BINARY_OPERATOR(&=)   \
+  TM_DEFINE_BINARY_OPERATOR(^=)   \
+  TM_DEFINE_BINARY_OPERATOR(|=)
 
 namespace tm_robot_listener {
 namespace detail {
 
-struct statement_to_string {
-  template <typename T>
-  std::string operator()(Expression<T> const& t_expr) const noexcept {
-    return t_expr();
+template <typename T>
+static constexpr bool is_statement = is_named_var<T> or is_expression<T>;
+
+/**
+ * @brief Node of an expression that is rendered already, e.g., declaration, or an expression whose type is erased
+ */
+struct RenderedNode {
+  std::string value_;
+
+  void render(std::string& t_out) const noexcept { t_out.append(this->value_); }
+};
+
+/**
+ * @brief Leaf of an expression tree that holds r-value operand
+ */
+template <typename T>
+struct Literal {
+  T value_;
+
+  void render(std::string& t_out) const noexcept { append_value(t_out, this->value_); }
+};
+
+/**
+ * @brief Leaf of an expression tree that refers to a Variable, so that its name is neither copied into the tree, nor
+ *        copied again by every operator above it
+ *
+ * @note  The Variable must outlive the expression, which is usually appended to a script in the same statement
+ */
+template <typename Var>
+struct VariableRef {
+  Var const* var_;
+
+  void render(std::string& t_out) const noexcept { this->var_->render(t_out); }
+};
+
+/**
+ * @brief Type of an operand kept in the expression tree, Variable is referred to, Expression is kept as it is
+ */
+template <typename T>
+using operand_t = std::conditional_t<is_named_var<T>, VariableRef<T>,
+                                     std::conditional_t<is_expression<T>, T, Literal<std::decay_t<T>>>>;
+
+template <typename T, std::enable_if_t<is_named_var<T>, bool> = true>
+inline VariableRef<T> make_operand(T const& t_operand) noexcept {
+  return VariableRef<T>{&t_operand};
+}
+
+template <typename T, std::enable_if_t<is_expression<T>, bool> = true>
+inline T const& make_operand(T const& t_operand) noexcept {
+  return t_operand;
+}
+
+template <typename T, std::enable_if_t<not is_statement<T>, bool> = true>
+inline auto make_operand(T const& t_operand) noexcept {
+  return Literal<std::decay_t<T>>{t_operand};
+}
+
+template <typename Operand, bool Postfix>
+struct UnaryNode {
+  char const* token_;
+  Operand operand_;
+
+  void render(std::string& t_out) const noexcept {
+    t_out.push_back('(');
+    if (not Postfix) {
+      t_out.append(this->token_);
+    }
+    this->operand_.render(t_out);
+    if (Postfix) {
+      t_out.append(this->token_);
+    }
+    t_out.push_back(')');
   }
+};
+
+template <typename Left, typename Right>
+struct BinaryNode {
+  char const* token_;
+  Left left_;
+  Right right_;
 
-  template <typename T>
-  std::string operator()(Variable<T> const& t_var) const noexcept {
-    return t_var();
+  void render(std::string& t_out) const noexcept {
+    t_out.push_back('(');
+    this->left_.render(t_out);
+    t_out.append(this->token_);
+    this->right_.render(t_out);
+    t_out.push_back(')');
   }
 };
 
-inline boost::xpressive::sregex var_name_pattern() noexcept {
-  static auto const var_name_regex = boost::xpressive::sregex::compile("^[a-zA-Z_][a-zA-Z0-9_]*$");
-  return var_name_regex;
-}
+template <typename Cond, typename Left, typename Right>
+struct TernaryNode {
+  Cond cond_;
+  Left left_;
+  Right right_;
+
+  void render(std::string& t_out) const noexcept {
+    t_out.push_back('(');
+    this->cond_.render(t_out);
+    t_out.push_back('?');
+    this->left_.render(t_out);
+    t_out.push_back(':');
+    this->right_.render(t_out);
+    t_out.push_back(')');
+  }
+};
+
+/**
+ * @brief Node of variable declaration, e.g., "float[] pose={0,0,0,0,0,0}"
+ */
+template <typename Var, typename Value>
+struct DeclarationNode {
+  char const* type_decl_; /*!< type of the element for array */
+  bool array_;
+  Var var_;
+  Value value_;
+
+  void render(std::string& t_out) const noexcept {
+    t_out.append(this->type_decl_);
+    if (this->array_) {
+      t_out.append("[]", 2);
+    }
+    t_out.push_back(' ');
+    this->var_.render(t_out);
+    t_out.push_back('=');
+    this->value_.render(t_out);
+  }
+};
 
 }  // namespace detail
 }  // namespace tm_robot_listener
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,195 @@
+#ifndef TMR_PREPARED_SCRIPT_HPP_
+#define TMR_PREPARED_SCRIPT_HPP_
+
+#include <boost/lexical_cast.hpp>
+#include <boost/utility/string_ref.hpp>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "tmr_fwd.hpp"
+#include "tmr_msg_gen.hpp"
+#include "tmr_stringifier.hpp"
+
+namespace tm_robot_listener {
+namespace motion_function {
+namespace detail {
+
+constexpr char SLOT_MARKER = '\x01'; /*!< slot placeholders are rendered as "\x01<index>\x01" */
+
+/**
+ * @brief This function returns the placeholder text of the t_index-th slot
+ */
+inline std::string slot_marker(std::size_t const t_index) {
+  return SLOT_MARKER + std::to_string(t_index) + SLOT_MARKER;
+}
+
+}  // namespace detail
+
+/**
+ * @brief Command list whose layout is rendered once, and whose argument slots can be re-bound afterwards, see prepare.
+ *        Binding a slot formats the value only, the length and the checksum of the frame are updated incrementally,
+ *        the rest of the script is never rebuilt.
+ *
+ * @tparam Tag  Header tag
+ *
+ * @note  The product is serialized as soon as it is returned from ListenerHandle::generate_cmd, it can be re-bound
+ *        and returned again afterwards
+ */
+template <typename Tag>
+class PreparedScript final : public BaseHeaderProduct {
+ private:
+  struct Slot {
+    std::string text_;
+    std::size_t occurrences_ = 0;
+    unsigned char xor_       = 0;
+    bool bound_              = false;
+  };
+
+  std::vector<std::string> segments_;         /*!< constant text around slots, one more than occurrence_slot_ */
+  std::vector<std::size_t> occurrence_slot_;  /*!< slot index of each placeholder, in order of appearance */
+  std::vector<Slot> slots_;
+  std::size_t payload_size_  = 0;  /*!< size of the data section, updated on bind */
+  unsigned char payload_xor_ = 0;  /*!< xor of the data section, updated on bind */
+  std::size_t unbound_slots_ = 0;
+  bool script_exit_;
+
+  std::size_t slot_index(std::string const& t_placeholder) const {
+    boost::string_ref const marker{t_placeholder};
+    std::size_t index = 0;
+    if (marker.size() < 3 or marker.front() != detail::SLOT_MARKER or marker.back() != detail::SLOT_MARKER or
+        not boost::conversion::try_lexical_convert(marker.data() + 1, marker.size() - 2, index) or
+        index >= this->slots_.size() or this->slots_[index].occurrences_ == 0) {
+      throw std::invalid_argument{"not a slot of the prepared script"};
+    }
+
+    return index;
+  }
+
+  void set_slot_text(std::size_t const t_index, std::string t_text) noexcept {
+    auto& slot = this->slots_[t_index];
+    auto const odd = slot.occurrences_ % 2 == 1;  // even occurrences cancel each other out in xor
+
+    this->payload_size_ -= slot.text_.size() * slot.occurrences_;
+    this->payload_xor_ ^= odd ? slot.xor_ : 0;
+
+    slot.text_ = std::move(t_text);
+    slot.xor_  = detail::xor_checksum(slot.text_.data(), slot.text_.data() + slot.text_.size());
+
+    this->payload_size_ += slot.text_.size() * slot.occurrences_;
+    this->payload_xor_ ^= odd ? slot.xor_ : 0;
+
+    if (not slot.bound_) {
+      slot.bound_ = true;
+      --this->unbound_slots_;
+    }
+  }
+
+ public:
+  explicit PreparedScript(HeaderProduct<Tag> const& t_product) : script_exit_{t_product.has_script_exit()} {
+    boost::string_ref payload{t_product.payload_};
+    this->payload_xor_ = t_product.payload_xor_;
+
+    for (auto start = payload.find(detail::SLOT_MARKER); start != boost::string_ref::npos;
+         start      = payload.find(detail::SLOT_MARKER)) {
+      auto const length = payload.substr(start + 1).find(detail::SLOT_MARKER);
+      if (length == boost::string_ref::npos) {
+        break;
+      }
+
+      std::size_t index = 0;
+      auto const marker = payload.substr(start, length + 2);
+      if (not boost::conversion::try_lexical_convert(marker.data() + 1, marker.size() - 2, index)) {
+        throw std::invalid_argument{"ill-formed slot placeholder"};
+      }
+
+      this->segments_.emplace_back(payload.substr(0, start).to_string());
+      this->occurrence_slot_.push_back(index);
+      this->slots_.resize(std::max(this->slots_.size(), index + 1));
+      ++this->slots_[index].occurrences_;
+
+      this->payload_xor_ ^= detail::xor_checksum(marker.data(), marker.data() + marker.size());
+      payload.remove_prefix(start + marker.size());
+    }
+
+    this->segments_.emplace_back(payload.to_string());
+    for (auto const& segment : this->segments_) {
+      this->payload_size_ += segment.size();
+    }
+
+    for (auto const& slot : this->slots_) {
+      this->unbound_slots_ += slot.occurrences_ == 0 ? 0 : 1;
+    }
+  }
+
+  /**
+   * @brief This function binds t_value to the slot, the slot must be created by script_slot and used in the script
+   *
+   * @throw std::invalid_argument if t_slot is not a slot of this script
+   */
+  template <typename T>
+  void bind(Variable<T> const& t_slot, T const& t_value) {
+    this->set_slot_text(this->slot_index(t_slot()), value_to_string<T>{}(t_value));
+  }
+
+  /**
+   * @brief This function returns whether every slot is bound, a script with unbound slot is considered empty, and is
+   *        therefore never sent
+   */
+  bool ready() const noexcept { return this->unbound_slots_ == 0; }
+
+  bool empty() const noexcept override { return this->segments_.empty() or not this->ready(); }
+
+  std::string to_str() const noexcept override {
+    std::string result;
+    this->serialize(result);
+    return result;
+  }
+
+  void serialize(std::string& t_out) const noexcept override {
+    if (this->empty()) {
+      return;
+    }
+
+    auto const header_size = std::strlen(Tag::HEADER());
+    t_out.reserve(t_out.size() + header_size + detail::decimal_width(this->payload_size_) + this->payload_size_ +
+                  sizeof(",,,*XX\r\n"));
+
+    t_out.append(Tag::HEADER(), header_size).push_back(',');
+    auto checksum = detail::xor_checksum(Tag::HEADER() + 1, Tag::HEADER() + header_size);
+    checksum ^= detail::append_decimal(t_out, this->payload_size_);
+    t_out.push_back(',');
+
+    t_out.append(this->segments_.front());
+    for (std::size_t i = 0; i < this->occurrence_slot_.size(); ++i) {
+      t_out.append(this->slots_[this->occurrence_slot_[i]].text_).append(this->segments_[i + 1]);
+    }
+
+    t_out.push_back(',');
+    checksum ^= this->payload_xor_;
+    checksum ^= ',';  // xor of the three commas around length and data section
+
+    t_out.push_back('*');
+    detail::append_hex_byte(t_out, checksum);
+    t_out.append("\r\n", 2);
+  }
+
+  bool has_script_exit() const noexcept override { return this->script_exit_; }
+
+  boost::string_ref header() const noexcept override { return Tag::HEADER(); }
+
+  /**
+   * @note  The ID is expected to be constant, it is the part of the first segment
+   */
+  boost::string_ref response_key() const noexcept override {
+    boost::string_ref const first_segment{this->segments_.front()};
+    return first_segment.substr(0, first_segment.find(','));
+  }
+};
+
+}  // namespace motion_function
+}  // namespace tm_robot_listener
+
+#endif
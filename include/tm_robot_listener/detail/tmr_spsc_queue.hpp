@@ -0,0 +1,80 @@
+#ifndef TMR_SPSC_QUEUE_HPP_
+#define TMR_SPSC_QUEUE_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace tm_robot_listener {
+namespace detail {
+
+/**
+ * @brief Lock-free single producer single consumer queue of fixed capacity, nothing is allocated after construction.
+ *        Same layout as FrameLog, but the elements are copied in and out instead of being drained in place.
+ *
+ * @tparam T         element type, must be default constructible and copy assignable
+ * @tparam Capacity  maximum number of elements, must be power of 2
+ */
+template <typename T, std::size_t Capacity>
+class SpscQueue {
+  static_assert(Capacity != 0 and (Capacity & (Capacity - 1)) == 0, "Capacity must be power of 2");
+
+ private:
+  static constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+  std::array<T, Capacity> elements_{};
+
+  // head_ and tail_ are written by different threads, keep them away from each other
+  std::atomic<std::size_t> head_{0}; /*!< next slot to write, owned by the producer */
+  char head_padding_[CACHE_LINE_SIZE]{};
+  std::atomic<std::size_t> tail_{0}; /*!< next slot to read, owned by the consumer */
+  char tail_padding_[CACHE_LINE_SIZE]{};
+
+ public:
+  /**
+   * @brief This function copies t_value into the queue, producer only
+   *
+   * @return false if the queue is full
+   */
+  bool try_push(T const& t_value) noexcept {
+    auto const head = this->head_.load(std::memory_order_relaxed);
+    if (head - this->tail_.load(std::memory_order_acquire) == Capacity) {
+      return false;
+    }
+
+    this->elements_[head & (Capacity - 1)] = t_value;
+    this->head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief This function returns the oldest element without removing it, consumer only
+   *
+   * @return nullptr if the queue is empty, the element stays valid until pop() is called
+   */
+  T const* front() const noexcept {
+    auto const tail = this->tail_.load(std::memory_order_relaxed);
+    return tail == this->head_.load(std::memory_order_acquire) ? nullptr : &this->elements_[tail & (Capacity - 1)];
+  }
+
+  /**
+   * @brief This function removes the oldest element, the queue must not be empty, consumer only
+   */
+  void pop() noexcept { this->tail_.store(this->tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+  /**
+   * @brief This function returns the number of elements, exact only if called by the producer or the consumer
+   */
+  std::size_t size() const noexcept {
+    return this->head_.load(std::memory_order_acquire) - this->tail_.load(std::memory_order_acquire);
+  }
+
+  bool empty() const noexcept { return this->size() == 0; }
+
+  static constexpr std::size_t capacity() noexcept { return Capacity; }
+};
+
+}  // namespace detail
+}  // namespace tm_robot_listener
+
+#endif
@@ -1,11 +1,16 @@
 #ifndef TMR_STRINGIFIER_HPP_
 #define TMR_STRINGIFIER_HPP_
 
+#include <algorithm>
 #include <array>
-#include <boost/algorithm/string.hpp>
+#include <atomic>
 #include <boost/lexical_cast.hpp>
-#include <boost/range/adaptors.hpp>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
 #include <string>
+#include <type_traits>
 
 namespace boost {
 
@@ -26,21 +31,299 @@ namespace tm_robot_listener {
 template <typename T>
 static constexpr auto lexical_cast_string = boost::lexical_cast<std::string, T>;
 
+namespace detail {
+
+constexpr std::size_t NUMBER_BUFFER_SIZE = 64; /*!< enough for any number written by write_number */
+constexpr int SHORTEST_ROUND_TRIP        = -1; /*!< precision value that disables fixed precision */
+
+/**
+ * @brief Precision of set_pose_precision, one per process, shared by every listener and handler in it
+ */
+inline std::atomic<int>& pose_precision_storage() noexcept {
+  static std::atomic<int> precision{SHORTEST_ROUND_TRIP};
+  return precision;
+}
+
+/**
+ * @brief Integer types formatted by write_number, character types are still formatted as characters
+ */
+template <typename T>
+using is_formatted_integer =
+  std::integral_constant<bool, std::is_integral<T>::value and not std::is_same<T, bool>::value and
+                                 not std::is_same<T, char>::value and not std::is_same<T, signed char>::value and
+                                 not std::is_same<T, unsigned char>::value>;
+
+template <typename T>
+using is_formatted_floating =
+  std::integral_constant<bool, std::is_same<T, float>::value or std::is_same<T, double>::value>;
+
 template <typename T>
+using is_formatted_number =
+  std::integral_constant<bool, is_formatted_integer<T>::value or is_formatted_floating<T>::value>;
+
+inline float parse_floating(char const* t_str, float /*unused*/) noexcept { return std::strtof(t_str, nullptr); }
+inline double parse_floating(char const* t_str, double /*unused*/) noexcept { return std::strtod(t_str, nullptr); }
+
+/**
+ * @brief This function writes t_value in decimal at t_first, the buffer must hold at least NUMBER_BUFFER_SIZE chars
+ *
+ * @return pointer past the last char written
+ */
+template <typename T, std::enable_if_t<is_formatted_integer<T>::value, int> = 0>
+inline char* write_number(char* t_first, T const t_value) noexcept {
+  using unsigned_t = std::make_unsigned_t<T>;
+
+  auto magnitude = static_cast<unsigned_t>(t_value);
+  if (t_value < 0) {
+    *t_first++ = '-';
+    magnitude  = static_cast<unsigned_t>(0U - magnitude);
+  }
+
+  char digits[std::numeric_limits<unsigned_t>::digits10 + 1];
+  auto last = digits;
+  do {
+    *last++ = static_cast<char>('0' + magnitude % 10);
+    magnitude /= 10;
+  } while (magnitude != 0);
+
+  while (last != digits) {
+    *t_first++ = *--last;
+  }
+  return t_first;
+}
+
+/**
+ * @brief Integers have no digit after the decimal point, t_precision is ignored
+ */
+template <typename T, std::enable_if_t<is_formatted_integer<T>::value, int> = 0>
+inline char* write_number(char* t_first, T const t_value, int const /*t_precision*/) noexcept {
+  return write_number(t_first, t_value);
+}
+
+constexpr double power_of_10(int const t_exponent) noexcept {
+  return t_exponent == 0 ? 1.0 : 10.0 * power_of_10(t_exponent - 1);
+}
+
+/**
+ * @brief This function writes t_value with at most digits10 significant digits in fixed notation, if that is enough
+ *        to read back as t_value, see write_number
+ *
+ * @details t_value * 10^k is rounded to integer for k = 1, 2, ..., the first integer that, divided by 10^k, gives
+ *          t_value back is the shortest text. The division is exact up to the final rounding, since both operands are
+ *          exact in double, and k is kept small enough that rounding to double first then to float never differs from
+ *          rounding to float directly.
+ *
+ * @return pointer past the last char written, nullptr if nothing is written
+ */
+template <typename T>
+inline char* write_short_decimal(char* t_first, T const t_value) noexcept {
+  constexpr auto MAX_SCALED         = power_of_10(std::numeric_limits<T>::digits10);
+  constexpr int MAX_FRACTION_DIGITS = std::numeric_limits<T>::digits10 + 1;
+
+  auto const value = static_cast<double>(t_value);
+  auto scale       = 1.0;
+  for (int fraction_digits = 1; fraction_digits <= MAX_FRACTION_DIGITS; ++fraction_digits) {
+    scale *= 10;
+    auto const scaled = std::abs(value) * scale;
+    if (not(scaled < MAX_SCALED)) {
+      return nullptr;
+    }
+
+    auto const digits = std::llround(scaled);
+    if (static_cast<T>(static_cast<double>(digits) / scale) != std::abs(t_value)) {
+      continue;
+    }
+
+    char text[NUMBER_BUFFER_SIZE];
+    auto const text_end = write_number(text, digits);
+    auto const size     = static_cast<int>(text_end - text);
+
+    if (t_value < 0) {
+      *t_first++ = '-';
+    }
+    if (size <= fraction_digits) {
+      *t_first++ = '0';
+      *t_first++ = '.';
+      t_first    = std::fill_n(t_first, fraction_digits - size, '0');
+      return std::copy(text, text_end, t_first);
+    }
+
+    t_first    = std::copy(text, text_end - fraction_digits, t_first);
+    *t_first++ = '.';
+    return std::copy(text_end - fraction_digits, text_end, t_first);
+  }
+
+  return nullptr;
+}
+
+/**
+ * @brief This function writes the shortest text that reads back as t_value at t_first, the buffer must hold at least
+ *        NUMBER_BUFFER_SIZE chars
+ *
+ * @details Integral values are written as integers, values with few decimal digits, e.g., 417.5, are written by
+ *          write_short_decimal without going through printf. Others are printed with digits10 significant digits
+ *          first, which is the shortest round-trip text whenever there is one that short (trailing zeros are dropped
+ *          by %g), then with one more digit at a time up to max_digits10, which always round-trips.
+ *
+ * @return pointer past the last char written
+ */
+template <typename T, std::enable_if_t<is_formatted_floating<T>::value, int> = 0>
+inline char* write_number(char* t_first, T const t_value) noexcept {
+  constexpr auto MAX_EXACT_INTEGER = static_cast<T>(1LL << std::numeric_limits<T>::digits);
+
+  if (std::abs(t_value) < MAX_EXACT_INTEGER and std::trunc(t_value) == t_value) {
+    return write_number(t_first, static_cast<long long>(t_value));
+  }
+
+  if (auto const last = write_short_decimal(t_first, t_value)) {
+    return last;
+  }
+
+  int size = 0;
+  for (auto digits = std::numeric_limits<T>::digits10; digits <= std::numeric_limits<T>::max_digits10; ++digits) {
+    size = std::snprintf(t_first, NUMBER_BUFFER_SIZE, "%.*g", digits, static_cast<double>(t_value));
+    if (parse_floating(t_first, t_value) == t_value) {
+      break;
+    }
+  }
+
+  return t_first + size;
+}
+
+/**
+ * @brief This function writes t_value with t_precision digits after the decimal point, trailing zeros are dropped
+ *
+ * @note  Values too large to be written in NUMBER_BUFFER_SIZE chars are written as shortest round-trip text instead
+ */
+template <typename T, std::enable_if_t<is_formatted_floating<T>::value, int> = 0>
+inline char* write_number(char* t_first, T const t_value, int const t_precision) noexcept {
+  if (t_precision < 0 or not(std::abs(t_value) < static_cast<T>(1e15)) or t_precision > 15) {
+    return write_number(t_first, t_value);
+  }
+
+  auto last = t_first + std::snprintf(t_first, NUMBER_BUFFER_SIZE, "%.*f", t_precision, static_cast<double>(t_value));
+  if (t_precision != 0) {
+    while (*(last - 1) == '0') {
+      --last;
+    }
+    last -= *(last - 1) == '.' ? 1 : 0;
+  }
+
+  if (last - t_first == 2 and t_first[0] == '-' and t_first[1] == '0') {  // e.g., -0.0001 with precision 3
+    t_first[0] = '0';
+    --last;
+  }
+  return last;
+}
+
+/**
+ * @brief This function appends t_value to t_out, see write_number
+ */
+template <typename T>
+inline void append_number(std::string& t_out, T const t_value, int const t_precision = SHORTEST_ROUND_TRIP) noexcept {
+  char buffer[NUMBER_BUFFER_SIZE];
+  t_out.append(buffer, write_number(buffer, t_value, t_precision));
+}
+
+}  // namespace detail
+
+/**
+ * @brief This function returns the number of digits after the decimal point used for arrays of floating point values,
+ *        e.g., poses, or -1 if the shortest round-trip text is used (default)
+ */
+inline int pose_precision() noexcept { return detail::pose_precision_storage().load(std::memory_order_relaxed); }
+
+/**
+ * @brief This function sets the number of digits after the decimal point used for arrays of floating point values,
+ *        e.g., poses. Negative value restores the shortest round-trip text.
+ *
+ * @code{.cpp}
+ *
+ *    set_pose_precision(3);  // {417.123,-122.5,365,180,0,90}
+ *
+ * @endcode
+ *
+ * @note  The precision is process-wide, not per handler or per listener. Every listener run by
+ *        tm_robot_listener_manager, or loaded into the same nodelet manager, formats its poses with it, and a handler
+ *        setting it changes the scripts of every other handler. Set it once before the listeners start, e.g. in main.
+ */
+inline void set_pose_precision(int const t_precision) noexcept {
+  detail::pose_precision_storage().store(t_precision < 0 ? detail::SHORTEST_ROUND_TRIP : t_precision,
+                                         std::memory_order_relaxed);
+}
+
+template <typename T, typename Enable = void>
 struct value_to_string {
   std::string operator()(T const& t_in) const noexcept { return boost::lexical_cast<std::string>(t_in); }
 };
 
+template <typename T>
+struct value_to_string<T, std::enable_if_t<detail::is_formatted_number<T>::value>> {
+  std::string operator()(T const t_in) const noexcept {
+    std::string result;
+    detail::append_number(result, t_in);
+    return result;
+  }
+};
+
+namespace detail {
+
+/**
+ * @brief This function appends t_value in the form value_to_string does, numbers and arrays of numbers are formatted in
+ *        place
+ */
+template <typename T, std::enable_if_t<is_formatted_number<T>::value, int> = 0>
+inline void append_value(std::string& t_out, T const t_value) noexcept {
+  append_number(t_out, t_value);
+}
+
+template <typename T, std::size_t N, std::enable_if_t<is_formatted_number<T>::value, int> = 0>
+inline void append_value(std::string& t_out, std::array<T, N> const& t_value) noexcept {
+  auto const precision = is_formatted_floating<T>::value ? pose_precision() : SHORTEST_ROUND_TRIP;
+
+  t_out.push_back('{');
+  for (std::size_t i = 0; i < N; ++i) {
+    if (i != 0) {
+      t_out.push_back(',');
+    }
+    append_number(t_out, t_value[i], precision);
+  }
+  t_out.push_back('}');
+}
+
+template <typename T, std::enable_if_t<not is_formatted_number<T>::value, int> = 0>
+inline void append_value(std::string& t_out, T const& t_value) noexcept {
+  t_out.append(value_to_string<T>{}(t_value));
+}
+
+}  // namespace detail
+
+template <typename T, std::size_t N>
+struct value_to_string<std::array<T, N>, std::enable_if_t<detail::is_formatted_number<T>::value>> {
+  std::string operator()(std::array<T, N> const& t_in) const noexcept {
+    std::string result;
+    result.reserve(N * 8 + 2);
+    detail::append_value(result, t_in);
+    return result;
+  }
+};
+
 template <typename T, std::size_t N>
-struct value_to_string<std::array<T, N>> {
+struct value_to_string<std::array<T, N>, std::enable_if_t<not detail::is_formatted_number<T>::value>> {
   std::string operator()(std::array<T, N> const& t_in) const noexcept {
-    using namespace boost::algorithm;
-    using namespace boost::adaptors;
+    std::string result{'{'};
+    for (std::size_t i = 0; i < N; ++i) {
+      if (i != 0) {
+        result.push_back(',');
+      }
+      result.append(lexical_cast_string<T>(t_in[i]));
+    }
+    result.push_back('}');
 
-    return '{' + join(t_in | transformed(lexical_cast_string<T>), ",") + '}';
+    return result;
   }
 };
 
 }  // namespace tm_robot_listener
 
-#endif
\ No newline at end of file
+#endif
@@ -2,49 +2,150 @@
 #define TM_ROBOT_LISTENER_HPP_
 
 #include <boost/asio.hpp>
-#include <boost/asio/steady_timer.hpp>
-#include <boost/range/adaptors.hpp>
 #include <boost/thread.hpp>
+#include <boost/utility/string_ref.hpp>
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <cstdint>
+#include <deque>
 #include <memory>
+#include <random>
 
+#include "tm_robot_listener/detail/tmr_backoff.hpp"
+#include "tm_robot_listener/detail/tmr_frame_log.hpp"
+#include "tm_robot_listener/detail/tmr_handler_slots.hpp"
+#include "tm_robot_listener/detail/tmr_latency_histogram.hpp"
+#include "tm_robot_listener/detail/tmr_spsc_queue.hpp"
 #include "tmr_listener_handle/tmr_listener_handle.hpp"
 
 #include <pluginlib/class_loader.h>
+#include <ros/callback_queue.h>
 #include <ros/ros.h>
+#include <tm_robot_listener/CPERRResponseStamped.h>
+#include <tm_robot_listener/LatencyReport.h>
+#include <tm_robot_listener/ListenerCmd.h>
+#include <tm_robot_listener/TMSCTResponseStamped.h>
+#include <tm_robot_listener/TMSTAResponseStamped.h>
 
 namespace tm_robot_listener {
 
 class TMRobotListener {
  private:
   class ScriptExitHandler final : public ListenerHandle {
-   protected:
-    motion_function::BaseHeaderProductPtr generate_cmd(MessageStatus /*unused*/) override {
+   public:
+    /**
+     * @brief This function returns the ScriptExit() sent when no handler accepts the listen node. The listener
+     *        queues it directly, since nothing ever answers the request recorded by generate_request.
+     */
+    static motion_function::BaseHeaderProductPtr script_exit() {
       using namespace motion_function;
-      return TMSCT << ID{"TMRobotListener_DefaultHandler"} << ScriptExit();
+      return cached_frame([] { return TMSCT << ID{"TMRobotListener_DefaultHandler"} << ScriptExit(); });
     }
 
+   protected:
+    motion_function::BaseHeaderProductPtr generate_cmd(MessageStatus /*unused*/) override { return script_exit(); }
+
     Decision start_task(std::vector<std::string> const & /*unused*/) override { return Decision::Ignore; }
   };
 
-  using TMTaskHandler        = boost::shared_ptr<ListenerHandle>;
-  using TMTaskHandlerArray_t = std::vector<TMTaskHandler>;
+  using TMTaskHandler = boost::shared_ptr<ListenerHandle>;
+
+  using FrameLog_t = FrameLog<1024, 240>;
+  using Clock      = std::chrono::steady_clock;
+
+  /**
+   * @brief Stages timed along the path of a message, see "Latency statistics" in README.md
+   */
+  enum class LatencyStage : std::uint8_t { Parse, Dispatch, Generate, Serialize, Write, RoundTrip, Count };
+
+  /**
+   * @brief Latency measured by the I/O thread, recorded into the histograms by the ROS spinner thread
+   */
+  struct LatencySample {
+    LatencyStage stage_;
+    std::uint8_t header_; /*!< index into LATENCY_HEADERS */
+    std::size_t handler_; /*!< index into task_handlers_, NO_HANDLER if no handler is involved */
+    std::chrono::nanoseconds latency_;
+  };
+
+  using LatencyQueue_t      = detail::SpscQueue<LatencySample, 4096>;
+  using LatencyHistograms_t = std::array<detail::LatencyHistogram, static_cast<std::size_t>(LatencyStage::Count)>;
+
+  /**
+   * @brief Frame waiting to be written, either serialized into buffer_, or prebuilt_, whose frame is written as is
+   */
+  struct QueuedFrame {
+    std::string buffer_;
+    motion_function::BaseHeaderProductPtr prebuilt_;
+    Clock::time_point queued_at_; /*!< when the frame is serialized, the write latency is measured from here */
+    std::uint8_t header_ = 0;
+    std::size_t handler_ = detail::HandlerIndex::NOT_FOUND;
+
+    boost::string_ref bytes() const noexcept {
+      return this->prebuilt_ ? this->prebuilt_->prebuilt_frame() : boost::string_ref{this->buffer_};
+    }
+  };
+
+  /**
+   * @brief Script injected through ~listener_cmd that waits for its response, see take_injected_response
+   */
+  struct InjectedRequest {
+    std::string header_;
+    std::string key_; /*!< TMSCT ID or TMSTA sub command */
+    Clock::time_point queued_at_;
+  };
 
   static constexpr auto TMR_INIT_MSG_ID  = "0";    /* !< TM robot message id when first enter listen node */
   static constexpr auto MESSAGE_END_BYTE = "\r\n"; /* !< TM script message ends with this 2 bytes, \r\n */
+  static constexpr auto NO_HANDLER       = detail::HandlerIndex::NOT_FOUND;
 
-  static constexpr auto HEADER_INDEX       = 0; /*!< Index of the HEADER byte in the tokenized rx msg */
-  static constexpr auto LENGTH_INDEX       = 1; /*!< Index of the LENGTH byte in the tokenized rx msg */
-  static constexpr auto DATA_START_INDEX   = 2; /*!< Index of the Data byte in tokenized rx msg */
-  static constexpr auto ID_INDEX           = DATA_START_INDEX + 0;
-  static constexpr auto SCRIPT_START_INDEX = DATA_START_INDEX + 1;
+  static constexpr auto RESPONSE_QUEUE_SIZE = 100U; /*!< of the topics the responses are published on */
+
+  static constexpr std::array<char const *, 4> LATENCY_HEADERS{{"TMSCT", "TMSTA", "CPERR", "other"}};
+  static constexpr std::array<char const *, static_cast<std::size_t>(LatencyStage::Count)> LATENCY_STAGES{
+    {"parse", "dispatch", "generate", "serialize", "write", "round_trip"}};
 
   /**
-   * @brief This function checks ros::ok periodically to shutdown the connection immediately
-   *
-   * @param t_err system error happened when invoking timer
+   * @brief TCP keepalive of the connection, so that a robot powered off without closing the connection is noticed
+   */
+  struct KeepAliveOptions {
+    bool enabled_ = true;
+    int idle_     = 5; /*!< seconds of silence before the first probe */
+    int interval_ = 1; /*!< seconds between probes */
+    int count_    = 3; /*!< unanswered probes before the connection is dropped */
+  };
+
+  /**
+   * @brief This function reads the parameters of the connection: backoff, connect timeout and TCP keepalive, see
+   *        "Connection" in README.md
+   */
+  void configure_connection() noexcept;
+
+  /**
+   * @brief This function initiates a connection attempt, which is abandoned once connect_timeout_ passes
+   */
+  void connect() noexcept;
+
+  /**
+   * @brief This function closes the socket, and attempts to connect again once the backoff delay passes
    */
-  void check_ros_heartbeat(boost::system::error_code const &t_err) noexcept;
+  void schedule_reconnect() noexcept;
+
+  /**
+   * @brief This function applies keep_alive_ to the connected socket
+   */
+  void set_keep_alive() noexcept;
+
+  /**
+   * @brief This function moves the connection to t_state, and tells every handler created so far if it changes
+   */
+  void set_connection_state(ConnectionState t_state) noexcept;
+
+  /**
+   * @brief This function ends the handling of the listen node, once ScriptExit() is queued
+   */
+  void end_task() noexcept;
 
   /**
    * @brief This function handles the connection and initiate the read process if the connection succeeded
@@ -54,13 +155,14 @@ class TMRobotListener {
   void handle_connection(boost::system::error_code const &t_err) noexcept;
 
   /**
-   * @brief This function extract buffer data from boost asio streambuf and store the result to std::string
+   * @brief This function returns the first t_byte_to_view bytes of the boost asio streambuf without copying, the
+   *        returned view is invalidated once the buffer is consumed
    *
-   * @param t_buffer  Buffer to extract data
-   * @param t_byte_to_extract Number of byte to extract
-   * @return extracted data
+   * @param t_buffer  Buffer to view
+   * @param t_byte_to_view Number of byte to view
+   * @return view of the buffer data
    */
-  static std::string extract_buffer_data(boost::asio::streambuf &t_buffer, size_t t_byte_to_extract) noexcept;
+  static boost::string_ref view_buffer_data(boost::asio::streambuf const &t_buffer, size_t t_byte_to_view) noexcept;
 
   /**
    * @brief This function handles the read process of TCP connection, once entered listen node, it will initiate the
@@ -72,61 +174,302 @@ class TMRobotListener {
   void handle_read(boost::system::error_code const &t_err, size_t t_byte_transfered) noexcept;
 
   /**
-   * @brief This function handles the write process of TCP connection, it will continue writing once triggered, until
-   *        current_handler_ is reset.
+   * @brief This function handles the completion of the write process of TCP connection, it recycles the frames sent
+   *        and continues writing, until current_handler_ is reset.
    *
    * @param t_err system error happened during write process
    * @param t_byte_writtened Number of byte written to TM robot
    */
   void handle_write(boost::system::error_code const &t_err, size_t t_byte_writtened) noexcept;
 
+  /**
+   * @brief This function serializes t_cmd into a recycled frame buffer and appends it to the write queue, prebuilt
+   *        commands are queued as is
+   *
+   * @param t_cmd     command to send, ignored if empty
+   * @param t_handler index of the handler that generated t_cmd, for latency statistics
+   */
+  void enqueue_frame(motion_function::BaseHeaderProductPtr const &t_cmd, std::size_t t_handler = NO_HANDLER) noexcept;
+
+  /**
+   * @brief This function keeps the buffer of a sent or discarded frame for later use
+   */
+  void recycle_frame(QueuedFrame &t_frame) noexcept;
+
+  /**
+   * @brief This function asks current_task_handler_ for commands until it has nothing to send, or the write queue is
+   *        full
+   */
+  void queue_request() noexcept;
+
+  /**
+   * @brief This function sends every queued frame with one gathered write, unless a write is already in progress
+   */
+  void flush_write_queue() noexcept;
+
+  /**
+   * @brief This function drives the write process: it queues requests, flushes the queue, and prepares the next frames
+   *        while the write is in progress. If there is nothing to send yet, current_task_handler_ is asked again on
+   *        the next event, i.e., a response is read, a write completes, or the handler wakes the listener up, and at
+   *        the latest after handler_poll_period_.
+   */
+  void write_request() noexcept;
+
   /**
    * @brief Thread function that initializes and runs the IO services
    */
   void listener_node();
 
+  /**
+   * @brief This function prints the frames logged by the I/O thread, it runs periodically in the ROS spinner thread,
+   *        which is the only consumer of frame_log_
+   */
+  void drain_frame_log(ros::WallTimerEvent const &t_event) noexcept;
+
+  /**
+   * @brief This function publishes t_frame on the topic of its header, the frame is parsed only if the topic has
+   *        subscribers
+   *
+   * @param t_round_trip  round trip time of the request t_frame responds to, see ListenerHandle::last_round_trip
+   * @param t_read_time   time t_frame is read from the socket, the stamp of the message
+   */
+  void publish_response(FrameView const &t_frame, Clock::duration t_round_trip, ros::Time const &t_read_time) noexcept;
+
+  /**
+   * @brief This function serves ~listener_cmd on a thread of its own, see listener_cmd_queue_. It verifies the
+   *        script, and waits until the I/O thread queues it, see inject_command
+   */
+  bool handle_listener_cmd(ListenerCmd::Request &t_req, ListenerCmd::Response &t_res) noexcept;
+
+  /**
+   * @brief This function queues a script submitted by another node, without asking current_task_handler_
+   *
+   * @param t_urgent  the script is sent before any frame of normal priority that is not yet being written
+   * @return empty if the script is queued, the reason otherwise
+   */
+  std::string inject_command(motion_function::BaseHeaderProductPtr const &t_cmd, bool t_urgent) noexcept;
+
+  /**
+   * @brief This function takes t_frame if it responds to a script injected through ~listener_cmd, so that it doesn't
+   *        reach current_task_handler_, which didn't send the script
+   *
+   * @return true if t_frame is taken
+   */
+  bool take_injected_response(FrameView const &t_frame) noexcept;
+
+  /**
+   * @brief This function passes a latency to the ROS spinner thread, it never blocks, the sample is counted as dropped
+   *        if the queue is full
+   */
+  void record_latency(LatencyStage t_stage, std::uint8_t t_header, std::size_t t_handler,
+                      Clock::duration t_latency) noexcept;
+
+  /**
+   * @brief This function returns the index of t_header in LATENCY_HEADERS, unknown headers are counted as "other"
+   */
+  static std::uint8_t latency_header(boost::string_ref t_header) noexcept;
+
+  /**
+   * @brief This function records the samples queued by the I/O thread into the histograms, and reports them every
+   *        latency_report_period seconds, see report_latency. It runs every latency_collect_period seconds in the ROS
+   *        spinner thread, which is the only consumer of latency_samples_.
+   */
+  void collect_latency(ros::WallTimerEvent const &t_event) noexcept;
+
+  /**
+   * @brief This function logs the summary of the histograms, publishes them on ~latency if anyone subscribes, and
+   *        resets them
+   */
+  void report_latency() noexcept;
+
+  /**
+   * @brief This function returns the index of the first handler that accepts the listen node
+   *
+   * @param t_data  data section of the message sent when entering listen node, the first item is the node message
+   * @return NO_HANDLER if none does
+   */
+  std::size_t find_task_handler(std::vector<std::string> const &t_data) noexcept;
+
   /**
    * @brief This function handles reconnection when fail situation detected during read/write stage
    */
   void reconnect() noexcept;
 
   /**
-   * @brief Get the all plugin object
+   * @brief This function returns the services offered to the handlers: waking the write process up from any thread,
+   *        and running jobs on worker_service_, see AsyncListenerHandle
    */
-  auto get_all_plugins() {
-    using boost::adaptors::transformed;
-    auto const plugin_transformer = [this](auto const &t_name) { return this->class_loader_.createInstance(t_name); };
-    auto const plugin_names       = this->private_nh_.param("listener_handles", std::vector<std::string>{});
-    ROS_DEBUG_STREAM_NAMED("tm_robot_listener", "plugin num: " << plugin_names.size());
+  HandlerContext handler_context() noexcept;
 
-    auto const plugins = plugin_names | transformed(plugin_transformer);
-    return TMTaskHandlerArray_t{plugins.begin(), plugins.end()};
+  TMRobotListener(std::unique_ptr<boost::asio::io_service> t_io_service, std::string const &t_ip_addr) noexcept
+    : TMRobotListener{*t_io_service, ros::NodeHandle{"~/"}, t_ip_addr} {
+    this->owned_io_service_ = std::move(t_io_service);
   }
 
-  boost::asio::io_service io_service_;
+  /**
+   * @brief This function reads listener_handles, and creates every handler except the lazy ones, see
+   *        lazy_listener_handles in README.md. The handlers are indexed by their listen node messages, and the time
+   *        taken is reported.
+   */
+  void load_task_handlers() noexcept;
+
+  /**
+   * @brief This function creates the handler named t_name, and attaches it to the listener
+   *
+   * @return nullptr if the plugin fails to be created
+   */
+  TMTaskHandler create_task_handler(std::string const &t_name) noexcept;
+
+  /**
+   * @brief This function reads lazy_listener_handles, the listen node messages of each lazy handler by its name, see
+   *        detail::parse_lazy_handles
+   */
+  detail::LazyMessages lazy_handler_messages() const noexcept;
+
+  std::unique_ptr<boost::asio::io_service> owned_io_service_; /*!< only if the listener runs its own io service */
+  boost::asio::io_service &io_service_;
+  boost::asio::io_service::strand strand_{io_service_}; /*!< serializes handlers if the io service is shared */
   boost::asio::ip::address robot_address_;
   boost::asio::ip::tcp::endpoint tm_robot_{robot_address_, LISTENER_PORT};
   boost::asio::ip::tcp::socket listener_{io_service_};
-  boost::asio::steady_timer ros_heartbeat_timer_{io_service_};
   boost::asio::streambuf input_buffer_;
-  std::string output_buffer_;
+
+  std::atomic<ConnectionState> connection_state_{ConnectionState::Disconnected};
+  detail::Backoff reconnect_backoff_;
+  std::minstd_rand jitter_rng_{std::random_device{}()};
+  Clock::duration connect_timeout_{std::chrono::seconds{3}};
+  KeepAliveOptions keep_alive_;
+  boost::asio::steady_timer reconnect_timer_{io_service_}; /*!< waits for the backoff delay */
+  boost::asio::steady_timer connect_timer_{io_service_};   /*!< abandons a connection attempt taking too long */
 
   boost::thread listener_node_thread_;
 
-  ros::NodeHandle private_nh_{"~/"};
+  ros::NodeHandle private_nh_;
   pluginlib::ClassLoader<ListenerHandle> class_loader_{"tm_robot_listener", "tm_robot_listener::ListenerHandle"};
 
   TMTaskHandler default_task_handler_{boost::make_shared<ScriptExitHandler>()};
-  TMTaskHandlerArray_t task_handlers_{};
+  detail::HandlerSlots<TMTaskHandler> task_handlers_;
   TMTaskHandler current_task_handler_{};
+  std::size_t current_handler_index_ = NO_HANDLER;
+
+  std::atomic<std::size_t> rejected_frames_{0};
+
+  FrameLog_t frame_log_; /*!< raw frames received and sent, printed by drain_frame_log */
+  ros::WallTimer frame_log_timer_;
+
+  LatencyQueue_t latency_samples_;
+  std::atomic<std::uint64_t> dropped_latency_samples_{0};
+  std::vector<std::unique_ptr<LatencyHistograms_t>> handler_latency_; /*!< by handler, created on first sample */
+  std::array<std::unique_ptr<LatencyHistograms_t>, LATENCY_HEADERS.size()> header_latency_;
+  Clock::duration latency_report_period_;
+  Clock::time_point next_latency_report_;
+  ros::WallTimer latency_timer_;
+  ros::Publisher latency_pub_;
+
+  ros::CallbackQueue listener_cmd_queue_; /*!< ~listener_cmd may wait for the I/O thread, it has its own spinner */
+  ros::ServiceServer listener_cmd_srv_;
+  std::unique_ptr<ros::AsyncSpinner> listener_cmd_spinner_;
+  ros::Publisher tmsct_pub_; /*!< every TMSCT message from TM robot, see publish_response */
+  ros::Publisher tmsta_pub_;
+  ros::Publisher cperr_pub_;
+
+  std::size_t max_queued_frames_;
+  std::deque<QueuedFrame> write_queue_;                   /*!< frames waiting for the next write */
+  std::deque<QueuedFrame> in_flight_frames_;              /*!< frames of the outstanding async_write */
+  std::vector<boost::asio::const_buffer> write_buffers_;  /*!< buffer sequence of in_flight_frames_ */
+  std::vector<std::string> free_frames_;                  /*!< sent frames, kept for their capacity */
+  std::size_t urgent_frames_ = 0; /*!< injected frames of high priority at the front of write_queue_ */
+  std::deque<InjectedRequest> injected_in_flight_; /*!< in the order they are injected */
+  bool write_in_progress_    = false;
+  bool poll_pending_         = false;
+  Clock::duration handler_poll_period_;
+  boost::asio::steady_timer poll_timer_{io_service_}; /*!< asks an idle handler again, see write_request */
+  bool stopping_             = false; /*!< set by stop(), only accessed through strand_ */
+
+  boost::asio::io_service worker_service_; /*!< runs jobs that must not block the I/O thread */
+  std::unique_ptr<boost::asio::io_service::work> worker_work_{
+    std::make_unique<boost::asio::io_service::work>(worker_service_)};
+  boost::thread_group workers_;
 
  public:
-  static constexpr auto HEARTBEAT_INTERVAL() { return std::chrono::milliseconds(100); }
   static constexpr auto DEFAULT_IP_ADDRESS = "192.168.1.2";
   static constexpr auto LISTENER_PORT      = 5890;
 
+  static constexpr std::size_t DEFAULT_MAX_QUEUED_FRAMES = 8;
+  static constexpr double DEFAULT_FRAME_LOG_PERIOD        = 0.5;
+  static constexpr double DEFAULT_LATENCY_COLLECT_PERIOD  = 0.5;
+  static constexpr double DEFAULT_LATENCY_REPORT_PERIOD   = 10.0;
+  static constexpr int DEFAULT_WORKER_THREADS             = 1;
+  static constexpr double DEFAULT_HANDLER_POLL_PERIOD     = 0.01;
+  static constexpr double DEFAULT_RECONNECT_MIN_DELAY     = 0.1;
+  static constexpr double DEFAULT_RECONNECT_MAX_DELAY     = 10.0;
+  static constexpr double DEFAULT_RECONNECT_FACTOR        = 2.0;
+  static constexpr double DEFAULT_RECONNECT_JITTER        = 0.2;
+  static constexpr double DEFAULT_CONNECT_TIMEOUT         = 3.0;
+
   explicit TMRobotListener(std::string const &t_ip_addr = DEFAULT_IP_ADDRESS) noexcept
-    : robot_address_{boost::asio::ip::address::from_string(t_ip_addr)}, task_handlers_{get_all_plugins()} {}
+    : TMRobotListener{std::make_unique<boost::asio::io_service>(), t_ip_addr} {}
+
+  /**
+   * @brief Construct a listener that runs on an io service shared with other listeners, see TMRobotListenerManager
+   *
+   * @param t_io_service  io service to run on, the handlers of this listener are serialized by a strand, therefore
+   *                      the io service can be run by several threads
+   * @param t_nh          node handle to read parameters from, e.g. listener_handles, max_queued_frames
+   * @param t_ip_addr     IP address of the TM robot
+   */
+  TMRobotListener(boost::asio::io_service &t_io_service, ros::NodeHandle t_nh, std::string const &t_ip_addr) noexcept
+    : io_service_{t_io_service},
+      robot_address_{boost::asio::ip::address::from_string(t_ip_addr)},
+      private_nh_{std::move(t_nh)},
+      max_queued_frames_{static_cast<std::size_t>(
+        std::max(1, this->private_nh_.param("max_queued_frames", static_cast<int>(DEFAULT_MAX_QUEUED_FRAMES))))} {
+    auto const log_period  = this->private_nh_.param("frame_log_period", DEFAULT_FRAME_LOG_PERIOD);
+    this->frame_log_timer_ = this->private_nh_.createWallTimer(ros::WallDuration{log_period},
+                                                               &TMRobotListener::drain_frame_log, this);
+
+    std::chrono::duration<double> const report_period{
+      this->private_nh_.param("latency_report_period", DEFAULT_LATENCY_REPORT_PERIOD)};
+    this->latency_report_period_ = std::chrono::duration_cast<Clock::duration>(report_period);
+    this->next_latency_report_   = Clock::now() + this->latency_report_period_;
+    this->latency_pub_           = this->private_nh_.advertise<LatencyReport>("latency", 1);
+    this->configure_connection();
+
+    std::chrono::duration<double> const poll_period{
+      std::max(0.001, this->private_nh_.param("handler_poll_period", DEFAULT_HANDLER_POLL_PERIOD))};
+    this->handler_poll_period_ = std::chrono::duration_cast<Clock::duration>(poll_period);
+
+    auto const worker_count = std::max(1, this->private_nh_.param("worker_threads", DEFAULT_WORKER_THREADS));
+    for (int i = 0; i < worker_count; ++i) {
+      this->workers_.create_thread([this]() { this->worker_service_.run(); });
+    }
+
+    this->default_task_handler_->attach(this->handler_context());
+    this->load_task_handlers();
+    this->handler_latency_.resize(this->task_handlers_.size());
+    auto const collect_period = this->private_nh_.param("latency_collect_period", DEFAULT_LATENCY_COLLECT_PERIOD);
+    this->latency_timer_      = this->private_nh_.createWallTimer(ros::WallDuration{collect_period},
+                                                                  &TMRobotListener::collect_latency, this);
+    ros::NodeHandle cmd_nh{this->private_nh_};
+    cmd_nh.setCallbackQueue(&this->listener_cmd_queue_);
+    this->listener_cmd_srv_     = cmd_nh.advertiseService("listener_cmd", &TMRobotListener::handle_listener_cmd, this);
+    this->listener_cmd_spinner_ = std::make_unique<ros::AsyncSpinner>(1, &this->listener_cmd_queue_);
+    this->listener_cmd_spinner_->start();
+    this->tmsct_pub_ = this->private_nh_.advertise<TMSCTResponseStamped>("tmsct_response", RESPONSE_QUEUE_SIZE);
+    this->tmsta_pub_ = this->private_nh_.advertise<TMSTAResponseStamped>("tmsta_response", RESPONSE_QUEUE_SIZE);
+    this->cperr_pub_ = this->private_nh_.advertise<CPERRResponseStamped>("cperr_response", RESPONSE_QUEUE_SIZE);
+  }
+
+  TMRobotListener(TMRobotListener const & /*unused*/) = delete;
+  TMRobotListener(TMRobotListener && /*unused*/)      = delete;
+
+  TMRobotListener &operator=(TMRobotListener const & /*unused*/) = delete;
+  TMRobotListener &operator=(TMRobotListener && /*unused*/) = delete;
+
+  /**
+   * @brief Jobs still queued on the worker pool are dropped, the ones running are waited for
+   */
+  ~TMRobotListener();
 
   /**
    * @brief This function is the entry point to the TCP/IP connection, it initiates the thread loop and runs io services
@@ -135,9 +478,27 @@ class TMRobotListener {
   void start();
 
   /**
-   * @brief This function stops the timer and closes the socket
+   * @brief This function initiates the connection to TM robot and returns immediately, the io service must be run by
+   *        the caller
+   */
+  void async_start() noexcept;
+
+  /**
+   * @brief This function requests the io service to close the socket, and not to reconnect afterwards. It returns
+   *        immediately, the listener is stopped once the io service runs out of work.
    */
   void stop() noexcept;
+
+  /**
+   * @brief This function returns the number of messages from TM robot that were dropped, either because the length or
+   *        checksum doesn't match, or because the data section cannot be parsed
+   */
+  std::size_t rejected_frame_count() const noexcept { return this->rejected_frames_.load(); }
+
+  /**
+   * @brief This function returns the state of the connection to TM robot, it can be called from any thread
+   */
+  ConnectionState connection_state() const noexcept { return this->connection_state_.load(); }
 };
 
 }  // namespace tm_robot_listener
@@ -0,0 +1,70 @@
+#ifndef TM_ROBOT_LISTENER_MANAGER_HPP_
+#define TM_ROBOT_LISTENER_MANAGER_HPP_
+
+#include <boost/asio.hpp>
+#include <boost/thread.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tm_robot_listener/tm_robot_listener.hpp"
+
+#include <ros/ros.h>
+
+namespace tm_robot_listener {
+
+/**
+ * @brief This class hosts several TM robot connections in one process. All listeners share one io service, which is
+ *        run by a pool of threads, each listener serializes its own handlers with a strand.
+ *
+ *        The robots are configured by private parameters, e.g.:
+ *
+ * @code{.yaml}
+ *
+ *    io_threads: 2
+ *    robots: [arm_left, arm_right]
+ *    arm_left:
+ *      ip: 192.168.1.2
+ *      listener_handles: ["tm_error_handler::TMErrorHandler"]
+ *    arm_right:
+ *      ip: 192.168.1.3
+ *      listener_handles: ["tm_error_handler::TMErrorHandler"]
+ *
+ * @endcode
+ */
+class TMRobotListenerManager {
+ private:
+  boost::asio::io_service io_service_;
+  boost::thread_group io_threads_;
+
+  ros::NodeHandle private_nh_;
+  std::vector<std::unique_ptr<TMRobotListener>> listeners_;
+  std::size_t thread_count_;
+
+  /**
+   * @brief Thread function that runs the shared io service
+   */
+  void run_io_service() noexcept;
+
+ public:
+  static constexpr std::size_t DEFAULT_THREAD_COUNT = 1;
+
+  explicit TMRobotListenerManager(ros::NodeHandle t_nh = ros::NodeHandle{"~/"});
+
+  /**
+   * @brief This function connects every robot, runs the io service on the thread pool, and blocks until ROS is
+   *        shutdown
+   */
+  void start();
+
+  /**
+   * @brief This function stops every listener, it returns immediately
+   */
+  void stop() noexcept;
+
+  std::size_t robot_count() const noexcept { return this->listeners_.size(); }
+};
+
+}  // namespace tm_robot_listener
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef TM_ROBOT_LISTENER_NODELET_HPP_
+#define TM_ROBOT_LISTENER_NODELET_HPP_
+
+#include <boost/asio.hpp>
+#include <boost/thread.hpp>
+#include <memory>
+
+#include "tm_robot_listener/tm_robot_listener.hpp"
+
+#include <nodelet/nodelet.h>
+
+namespace tm_robot_listener {
+
+/**
+ * @brief Nodelet hosting one TMRobotListener, so that it can share a process with the nodes it talks to, the
+ *        responses it publishes are then passed to them by pointer, see publish_response. The parameters are the same
+ *        as tm_robot_listener_node's, plus the private parameter ip, default TMRobotListener::DEFAULT_IP_ADDRESS.
+ *
+ * @details The listener runs on an io service of its own, on a thread owned by the nodelet, its timers and service
+ *          are served by the callback queue of the nodelet manager.
+ */
+class TMRobotListenerNodelet final : public nodelet::Nodelet {
+ private:
+  boost::asio::io_service io_service_;
+  std::unique_ptr<TMRobotListener> listener_;
+  boost::thread io_thread_;
+
+  void onInit() override;
+
+ public:
+  TMRobotListenerNodelet() = default;
+
+  TMRobotListenerNodelet(TMRobotListenerNodelet const & /*unused*/) = delete;
+  TMRobotListenerNodelet(TMRobotListenerNodelet && /*unused*/)      = delete;
+
+  TMRobotListenerNodelet &operator=(TMRobotListenerNodelet const & /*unused*/) = delete;
+  TMRobotListenerNodelet &operator=(TMRobotListenerNodelet && /*unused*/) = delete;
+
+  /**
+   * @brief The listener is stopped, and the io thread joined, before the listener is destroyed
+   */
+  ~TMRobotListenerNodelet() override;
+};
+
+}  // namespace tm_robot_listener
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef TMR_ASYNC_LISTENER_HANDLE_HPP_
+#define TMR_ASYNC_LISTENER_HANDLE_HPP_
+
+#include <atomic>
+#include <cstdint>
+
+#include "tmr_listener_handle/tmr_listener_handle.hpp"
+
+namespace tm_robot_listener {
+
+/**
+ * @brief Base class of handlers that take long to generate commands, e.g., waiting for vision data, or planning a
+ *        trajectory. generate_cmd_async runs on the worker pool of the listener, the I/O thread keeps reading and
+ *        writing meanwhile, and the command is sent as soon as it is ready.
+ *
+ * @details Only one command is generated at a time. While it is being generated, the listener is told that nothing
+ *          is ready yet, and the handler is not polled. Once it is ready, the handler wakes the listener up, which
+ *          then sends the command. If the handler is not attached to a listener, e.g., in unit tests, the command is
+ *          generated in place.
+ *
+ * @note  response_msg is still called on the I/O thread, possibly while generate_cmd_async is running, state shared
+ *        by the two must be synchronized by the derived class
+ */
+class AsyncListenerHandle : public ListenerHandle {
+ private:
+  enum class Stage { Idle, Generating, Ready };
+
+  std::atomic<Stage> stage_{Stage::Idle};
+  std::atomic<std::uint64_t> task_epoch_{0};    /*!< bumped on every task, commands of previous tasks are dropped */
+  motion_function::BaseHeaderProductPtr result_; /*!< published by stage_ */
+  std::uint64_t result_epoch_ = 0;               /*!< task_epoch_ result_ is generated for, published by stage_ */
+
+  void generate_in_background(MessageStatus t_prev_response, std::uint64_t t_epoch) noexcept;
+
+ protected:
+  /**
+   * @brief This function generates the next command, it runs on a worker thread and is allowed to block
+   *
+   * @param t_prev_response status of the requests when the generation started
+   */
+  virtual motion_function::BaseHeaderProductPtr generate_cmd_async(MessageStatus t_prev_response) = 0;
+
+  motion_function::BaseHeaderProductPtr generate_cmd(MessageStatus t_prev_response) final;
+
+  void task_started() noexcept override;
+
+ public:
+  bool generating() const noexcept final { return this->stage_.load(std::memory_order_acquire) == Stage::Generating; }
+};
+
+}  // namespace tm_robot_listener
+
+#endif
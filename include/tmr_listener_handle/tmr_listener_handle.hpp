@@ -1,16 +1,66 @@
 #ifndef TMR_LISTENER_HANDLE_HPP_
 #define TMR_LISTENER_HANDLE_HPP_
 
-#include <boost/tokenizer.hpp>
+#include <chrono>
+#include <cstdint>
+#include <functional>
 #include <iostream>
+#include <map>
 #include <string>
 
+#include "tm_robot_listener/detail/tmr_frame_parser.hpp"
 #include "tmr_listener_handle/tmr_motion_function.hpp"
 
 namespace tm_robot_listener {
 
 enum class Decision { Accept, Ignore };
 
+/**
+ * @brief State of the connection to TM robot, handlers are told every change, see
+ *        ListenerHandle::connection_state_changed
+ */
+enum class ConnectionState {
+  Disconnected, /*!< not connected, a connection is attempted once the backoff delay passes */
+  Connecting,   /*!< connection is being attempted */
+  Connected,    /*!< connected, TM robot is not in listen node */
+  InListenNode  /*!< TM robot entered listen node, until ScriptExit() is sent */
+};
+
+inline char const* to_string(ConnectionState const t_state) noexcept {
+  switch (t_state) {
+    case ConnectionState::Disconnected:
+      return "Disconnected";
+    case ConnectionState::Connecting:
+      return "Connecting";
+    case ConnectionState::Connected:
+      return "Connected";
+    case ConnectionState::InListenNode:
+      return "InListenNode";
+  }
+
+  return "Unknown";
+}
+
+/**
+ * @brief These functions parse the data section of a response from TM robot, round_trip_ is left untouched since it
+ *        is known only to the handler that sent the request, see ListenerHandle::handle_response
+ *
+ * @param t_response  message sent from TM, see parse_frame
+ * @param t_parsed    [out] parsed response
+ * @return false if the header of t_response doesn't match, or its data section cannot be parsed
+ */
+bool parse_response(FrameView const& t_response, TMSTAResponse& t_parsed) noexcept;
+bool parse_response(FrameView const& t_response, TMSCTResponse& t_parsed) noexcept;
+bool parse_response(FrameView const& t_response, CPERRResponse& t_parsed) noexcept;
+
+/**
+ * @brief Services the listener provides to its handlers, see ListenerHandle::attach
+ */
+struct HandlerContext {
+  std::function<void()> wake_up_;                        /*!< asks the listener to call generate_request again */
+  std::function<void(std::function<void()>)> post_work_; /*!< runs a job on the worker pool of the listener */
+};
+
 /**
  * @brief This function is the main interface exposed to the user, end user implement listen node task handler by
  *        inheriting this class. For detail description, see ["Creating your own listener handle" part in top level
@@ -20,14 +70,53 @@ class ListenerHandle {
  public:
   enum class MessageStatus { Responded, NotYetRespond };
 
+  static constexpr std::chrono::seconds DEFAULT_RESPONSE_TIMEOUT{10};
+
  private:
-  MessageStatus responded_ = MessageStatus::NotYetRespond;
+  struct PendingRequest {
+    std::uint64_t sequence_;
+    std::chrono::steady_clock::time_point generated_at_;
+  };
+
+  /**
+   * @brief Requests waiting for response, keyed by TMSCT ID or TMSTA sub command. Requests with the same key are
+   *        answered in the order they are sent, std::multimap keeps equivalent keys in insertion order.
+   */
+  using InFlightTable = std::multimap<std::string, PendingRequest, std::less<>>;
+
+  InFlightTable tmsct_in_flight_;
+  InFlightTable tmsta_in_flight_;
+  std::uint64_t request_sequence_ = 0;
+  std::chrono::steady_clock::duration last_round_trip_{};
+  std::chrono::steady_clock::duration response_timeout_{DEFAULT_RESPONSE_TIMEOUT};
+
+  HandlerContext context_;
+
+  /**
+   * @brief This function removes the oldest request that matches t_key, and returns how long it has been in flight
+   *
+   * @return round trip time, zero if no request matches
+   */
+  static std::chrono::steady_clock::duration take_in_flight(InFlightTable& t_table, boost::string_ref t_key) noexcept;
+
+  /**
+   * @brief This function removes the oldest request regardless of its key, CPERR is not tagged with ID, it can only
+   *        be the reply of the oldest request, since TM robot process requests in order
+   */
+  std::chrono::steady_clock::duration take_oldest_in_flight() noexcept;
+
+  /**
+   * @brief This function drops the requests that have been in flight longer than response_timeout_, TM robot is not
+   *        going to respond to them
+   */
+  void expire_in_flight() noexcept;
 
  protected:
   /**
    * @brief This function generates TM external script commands, this is left for end user to implement.
    *
-   * @param t_prev_response Did TM robot responded to previous message
+   * @param t_prev_response Did TM robot respond to all the messages sent previously, a handler that keeps several
+   *                        scripts in flight should check in_flight_count() instead
    * @return motion_function::BaseHeaderProductPtr
    */
   virtual motion_function::BaseHeaderProductPtr generate_cmd(MessageStatus t_prev_response) = 0;
@@ -51,7 +140,71 @@ class ListenerHandle {
    */
   virtual Decision start_task(std::vector<std::string> const& t_data) = 0;
 
+  /**
+   * @brief This function is called after the handler accepts a task, before any command is generated
+   */
+  virtual void task_started() noexcept {}
+
+  /**
+   * @brief This function is called on the I/O thread whenever the connection to TM robot changes its state, e.g., to
+   *        stop a motion planned in the background once the connection is lost
+   *
+   * @note  Handlers created lazily are told only the changes after they are created
+   */
+  virtual void connection_state_changed(ConnectionState /*unused*/) noexcept {}
+
+  /**
+   * @brief This function asks the listener to call generate_request again, e.g., once a command generated in the
+   *        background is ready. It can be called from any thread, and does nothing if the handler is not attached.
+   */
+  void wake_up() const noexcept {
+    if (this->context_.wake_up_) {
+      this->context_.wake_up_();
+    }
+  }
+
+  HandlerContext const& context() const noexcept { return this->context_; }
+
+  /**
+   * @brief This function sets how long a request may wait for its response, the ones waiting longer are dropped before
+   *        the next generate_cmd, as if they were responded, but without calling response_msg
+   *
+   * @param t_timeout zero to keep requests until they are responded, or the connection is lost
+   */
+  void set_response_timeout(std::chrono::steady_clock::duration const t_timeout) noexcept {
+    this->response_timeout_ = t_timeout;
+  }
+
+  /**
+   * @brief This function drops every request in flight, e.g., once the handler gives up waiting for them
+   */
+  void clear_in_flight() noexcept {
+    this->tmsct_in_flight_.clear();
+    this->tmsta_in_flight_.clear();
+  }
+
  public:
+  /**
+   * @brief This function returns the listen node messages the handler may accept, e.g., {"VisionFail"}. The listener
+   *        indexes the handlers by these messages when they are loaded, and asks only the matching ones, start_task
+   *        still decides whether to accept.
+   *
+   * @return empty (default) if the accepted messages are not known in advance, start_task is then asked for every
+   *         listen node
+   */
+  virtual std::vector<std::string> listen_node_messages() const { return {}; }
+
+  /**
+   * @brief This function is called by the listener before the handler is used, see HandlerContext
+   */
+  void attach(HandlerContext t_context) noexcept { this->context_ = std::move(t_context); }
+
+  /**
+   * @brief This function returns whether a command is being generated in the background, see AsyncListenerHandle.
+   *        The listener stops polling the handler meanwhile, and waits for wake_up().
+   */
+  virtual bool generating() const noexcept { return false; }
+
   /**
    * @brief This function parses the message TM sent when entered listen node, and check if the handler is the one to
    *        handle the task
@@ -63,13 +216,20 @@ class ListenerHandle {
    */
   Decision start_task_handling(std::vector<std::string> const& t_data) noexcept;
 
+  /**
+   * @brief This function tells the handler the connection to TM robot changed its state, requests in flight are
+   *        dropped once disconnected, since TM robot never responds to them
+   */
+  void handle_connection_state(ConnectionState t_state) noexcept;
+
   /**
    * @brief This function parses the messages sent from TM, after parsing the messages, it will call one of the
    *        callbacks (ListenerHandler::response_msg overload sets) according to the header of the message.
    *
-   * @param t_response  message sent from TM
+   * @param t_response  message sent from TM, see parse_frame
+   * @return true if the message is dispatched, false if its data section cannot be parsed
    */
-  void handle_response(std::vector<std::string> const& t_response) noexcept;
+  bool handle_response(FrameView const& t_response) noexcept;
 
   /**
    * @brief This function generates request to send to TM robot, it calls ListenerHandle::generate_cmd internally
@@ -78,6 +238,27 @@ class ListenerHandle {
    */
   motion_function::BaseHeaderProductPtr generate_request() noexcept;
 
+  /**
+   * @brief This function returns number of TMSCT and TMSTA requests that are not yet responded
+   */
+  std::size_t in_flight_count() const noexcept {
+    return this->tmsct_in_flight_.size() + this->tmsta_in_flight_.size();
+  }
+
+  /**
+   * @brief This function returns the round trip time of the response handled last, see handle_response
+   *
+   * @return zero if the response matches no request
+   */
+  std::chrono::steady_clock::duration last_round_trip() const noexcept { return this->last_round_trip_; }
+
+  /**
+   * @brief This function returns when the oldest request in flight is generated, CPERR is attributed to it
+   *
+   * @return time_point::max() if nothing is in flight
+   */
+  std::chrono::steady_clock::time_point oldest_in_flight() const noexcept;
+
   ListenerHandle()                                 = default;
   ListenerHandle(ListenerHandle const& /*unused*/) = default;
   ListenerHandle(ListenerHandle&& /*unused*/)      = default;
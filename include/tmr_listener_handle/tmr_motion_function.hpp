@@ -4,32 +4,44 @@
 #include <boost/format.hpp>
 #include <boost/fusion/include/at_key.hpp>
 #include <boost/make_shared.hpp>
+#include <boost/utility/string_ref.hpp>
+#include <chrono>
 #include <functional>
+#include <stdexcept>
 #include <string>
 #include <unordered_set>
 #include <vector>
 
+#include "tm_robot_listener/detail/tmr_frame_parser.hpp"
 #include "tm_robot_listener/detail/tmr_function.hpp"
 #include "tm_robot_listener/detail/tmr_msg_gen.hpp"
+#include "tm_robot_listener/detail/tmr_prepared_script.hpp"
 #include "tmr_variable.hpp"
 
 namespace tm_robot_listener {
 
 enum class ErrorCode { NoError, BadArgument, BadCheckSum, BadHeader, InvalidData, NotInListenNode = 0xF1 };
 
+/**
+ * @brief round_trip_ of the responses is the time between the generation of the matching request and the arrival of
+ *        the response, it is zero if the response doesn't match any request in flight, e.g. TMSTA sub command 90.
+ */
 struct TMSTAResponse {
   int subcmd_;
   std::vector<std::string> data_{};
+  std::chrono::steady_clock::duration round_trip_{};
 };
 
 struct TMSCTResponse {
   std::string id_{""};
   bool script_result_ = false;
   std::vector<int> abnormal_line_{};
+  std::chrono::steady_clock::duration round_trip_{};
 };
 
 struct CPERRResponse {
   ErrorCode err_ = ErrorCode::NoError;
+  std::chrono::steady_clock::duration round_trip_{};
 };
 
 namespace motion_function {
@@ -125,6 +137,20 @@ struct Header {
 
   friend bool operator==(std::string const& t_lhs, Header const& /*unused*/) noexcept { return Tag::HEADER() == t_lhs; }
   friend bool operator!=(std::string const& t_lhs, Header const& /*unused*/) noexcept { return Tag::HEADER() != t_lhs; }
+
+  friend bool operator==(Header const& /*unused*/, boost::string_ref const t_rhs) noexcept {
+    return t_rhs == Tag::HEADER();
+  }
+  friend bool operator!=(Header const& /*unused*/, boost::string_ref const t_rhs) noexcept {
+    return t_rhs != Tag::HEADER();
+  }
+
+  friend bool operator==(boost::string_ref const t_lhs, Header const& /*unused*/) noexcept {
+    return t_lhs == Tag::HEADER();
+  }
+  friend bool operator!=(boost::string_ref const t_lhs, Header const& /*unused*/) noexcept {
+    return t_lhs != Tag::HEADER();
+  }
 };
 
 // clang-format off
@@ -169,12 +195,128 @@ TMR_HEADER(CPERR);
  *
  * @endcode
  */
-inline auto empty_command_list() noexcept { return boost::make_shared<HeaderProduct<void>>(); }
+inline auto empty_command_list() noexcept {
+  static auto const ret_val = boost::make_shared<HeaderProduct<void>>();
+  return ret_val;
+}
+
+/**
+ * @brief This function renders the script generated by t_gen only once, the first time it is called, and returns the
+ *        same frame afterwards. Sending it costs neither building nor checksum calculation, tm_robot_listener passes
+ *        the rendered frame to the socket as is.
+ *
+ * @code{.cpp}
+ *
+ *    return cached_frame([] { return TMSCT << ID{"Stop"} << StopAndClearBuffer() << End(); });
+ *
+ * @endcode
+ *
+ * @tparam Generator  captureless callable returning BaseHeaderProductPtr, each lambda expression has its own cache
+ *
+ * @note  The frame is rendered once per Generator type, hence the script must not depend on any runtime value, which
+ *        is why capturing lambda is rejected
+ */
+template <typename Generator>
+BaseHeaderProductPtr cached_frame(Generator t_gen) {
+  static_assert(std::is_empty<Generator>::value, "cached_frame renders only once, the generator must not capture");
+  static BaseHeaderProductPtr const ret_val = boost::make_shared<PrebuiltHeaderProduct>(*t_gen());
+  return ret_val;
+}
+
+/**
+ * @brief This function wraps a TMSCT or TMSTA script rendered elsewhere, e.g. received from another node, so that it
+ *        can be sent as is, see PrebuiltHeaderProduct
+ *
+ * @param t_script  either a complete frame, e.g. "$TMSCT,8,1,Exit(),*75", whose length and checksum are verified, or
+ *                  the header and the data section only, e.g. "TMSCT,1,ScriptExit()", whose length and checksum are
+ *                  filled in. The trailing "\r\n" is optional.
+ *
+ * @throw std::invalid_argument if the frame is malformed, its length or checksum doesn't match, or it is neither
+ *        TMSCT nor TMSTA
+ *
+ * @note  The script is considered to exit the listen node if it contains "ScriptExit()"
+ */
+inline BaseHeaderProductPtr raw_frame(boost::string_ref t_script) {
+  if (t_script.ends_with("\r\n")) {
+    t_script.remove_suffix(2);
+  }
+
+  std::string frame;
+  if (t_script.starts_with('$')) {
+    frame.assign(t_script.data(), t_script.size());
+  } else {
+    auto const comma = t_script.find(',');
+    if (comma == boost::string_ref::npos) {
+      throw std::invalid_argument{"script has no data section"};
+    }
+
+    auto const data = t_script.substr(comma + 1);
+    frame.push_back('$');
+    frame.append(t_script.data(), comma).push_back(',');
+    detail::append_decimal(frame, data.size());
+    frame.push_back(',');
+    frame.append(data.data(), data.size()).push_back(',');
+
+    auto const checksum = detail::xor_checksum(frame.data() + 1, frame.data() + frame.size());
+    frame.push_back('*');
+    detail::append_hex_byte(frame, checksum);
+  }
+
+  frame.append("\r\n", 2);
+  auto const view = parse_frame(frame);
+  if (not view.valid()) {
+    throw std::invalid_argument{"script is malformed, or its length or checksum doesn't match"};
+  }
+
+  if (view.header_ != TMSCT and view.header_ != TMSTA) {
+    throw std::invalid_argument{"only TMSCT and TMSTA scripts can be sent"};
+  }
+
+  FieldTokenizer fields{view.payload_, ','};
+  boost::string_ref key;
+  fields.next(key);
+
+  auto header            = view.header_.to_string();
+  auto response_key      = key.to_string();
+  auto const script_exit = view.header_ == TMSCT and view.payload_.find("ScriptExit()") != boost::string_ref::npos;
+  return boost::make_shared<PrebuiltHeaderProduct>(std::move(frame), std::move(header), std::move(response_key),
+                                                   script_exit);
+}
 
 inline auto dummy_command_list(std::string t_dummy_cmd_id) noexcept {
   return TMSCT << ID{std::move(t_dummy_cmd_id)} << End();
 }
 
+/**
+ * @brief This function creates the t_index-th argument slot of a prepared script, the slot can be passed wherever a
+ *        Variable<T> is accepted, see prepare
+ */
+template <typename T>
+inline auto script_slot(std::size_t const t_index) {
+  return Variable<T>{detail::slot_marker(t_index)};
+}
+
+/**
+ * @brief This function renders the layout of t_product once, slots created by script_slot can then be bound again and
+ *        again, without rebuilding the script:
+ *
+ * @code{.cpp}
+ *
+ *    auto const pose  = script_slot<std::array<float, 6>>(0);
+ *    auto const speed = script_slot<int>(1);
+ *    auto const script = prepare(TMSCT << ID{"Servo"} << Line("CPP"s, pose, speed, 200, 0, false) << End());
+ *
+ *    script->bind(pose, std::array<float, 6>{417, -122, 365, 180, 0, 90});
+ *    script->bind(speed, 100);
+ *    return script;  // every slot must be bound before sending, see PreparedScript::ready
+ *
+ * @endcode
+ */
+template <typename Tag>
+inline auto prepare(boost::shared_ptr<HeaderProduct<Tag>> const& t_product) {
+  return boost::make_shared<PreparedScript<Tag>>(*t_product);
+}
+
 /**
  * @brief Motion function FunctionSet instances
  */
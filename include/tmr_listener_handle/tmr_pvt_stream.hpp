@@ -0,0 +1,124 @@
+#ifndef TMR_PVT_STREAM_HPP_
+#define TMR_PVT_STREAM_HPP_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+
+#include "tm_robot_listener/detail/tmr_spsc_queue.hpp"
+#include "tmr_listener_handle/tmr_motion_function.hpp"
+
+namespace tm_robot_listener {
+
+/**
+ * @brief One point of a PVT trajectory, see motion_function::PVTPoint
+ */
+struct PVTSample {
+  std::array<float, 6> position_{};
+  std::array<float, 6> velocity_{};
+  float duration_ = 0; /*!< time to reach position_ from the previous point, in seconds */
+};
+
+/**
+ * @brief This class streams an externally planned trajectory to TM robot in PVT mode. A producer thread pushes points
+ *        into a lock-free queue, the handler that owns the stream returns next_command() from generate_cmd, and
+ *        forwards every response to handle_response:
+ *
+ * @code{.cpp}
+ *
+ *    BaseHeaderProductPtr generate_cmd(MessageStatus) override { return this->stream_.next_command(); }
+ *    void response_msg(TMSTAResponse const& t_resp) override { this->stream_.handle_response(t_resp); }
+ *    void response_msg(TMSCTResponse const& t_resp) override { this->stream_.handle_response(t_resp); }
+ *    void response_msg(CPERRResponse const& t_resp) override { this->stream_.handle_response(t_resp); }
+ *
+ * @endcode
+ *
+ * @details Points are batched into TMSCT frames of about Options::frame_budget_ bytes, each frame ends with
+ *          QueueTag(tag). At most Options::look_ahead_ frames are queued in the robot without being done, the oldest
+ *          tag is polled with QueueTagDone once the look-ahead is full, or once there is nothing else to send. PVTEnter
+ *          is sent with the first point, PVTExit once finish() is called and every frame is done.
+ *
+ * @note  push() and finish() can be called from any single thread, the other functions must be called from the thread
+ *        that runs the handler
+ */
+class PVTStream {
+ public:
+  enum class Mode { Joint = 0, Cartesian = 1 };
+  enum class State { Idle, Streaming, Exiting, Done, Failed };
+
+  static constexpr std::size_t CAPACITY             = 1024; /*!< points the queue can hold */
+  static constexpr std::size_t DEFAULT_FRAME_BUDGET = 1000;
+  static constexpr std::size_t DEFAULT_LOOK_AHEAD   = 4;
+  static constexpr int MAX_QUEUE_TAG                = 15; /*!< QueueTag accepts 1 to 15 */
+
+  struct Options {
+    Mode mode_                = Mode::Joint;
+    std::size_t frame_budget_ = DEFAULT_FRAME_BUDGET; /*!< target size of the data section of each frame, in bytes */
+    std::size_t look_ahead_   = DEFAULT_LOOK_AHEAD;   /*!< frames queued in the robot, at most MAX_QUEUE_TAG */
+    std::chrono::steady_clock::duration poll_interval_{std::chrono::milliseconds{5}}; /*!< between QueueTagDone */
+  };
+
+  PVTStream() noexcept;
+  explicit PVTStream(Options const& t_options) noexcept;
+
+  /**
+   * @brief This function queues t_sample to be sent, producer only
+   *
+   * @return false if the queue is full, or if finish() is called already
+   */
+  bool push(PVTSample const& t_sample) noexcept;
+
+  /**
+   * @brief This function informs the stream that no more point will be pushed, PVT mode is exited after the last
+   *        point is done, producer only
+   */
+  void finish() noexcept { this->finished_.store(true, std::memory_order_release); }
+
+  /**
+   * @brief This function returns the next frame to send, empty if the stream is waiting for the producer or for the
+   *        robot, see class description
+   */
+  motion_function::BaseHeaderProductPtr next_command() noexcept;
+
+  void handle_response(TMSTAResponse const& t_response) noexcept;
+  void handle_response(TMSCTResponse const& t_response) noexcept;
+  void handle_response(CPERRResponse const& t_response) noexcept;
+
+  /**
+   * @brief This function prepares the stream for another trajectory, points still queued are kept, e.g., in
+   *        ListenerHandle::start_task
+   */
+  void reset() noexcept;
+
+  State state() const noexcept { return this->state_.load(std::memory_order_acquire); }
+
+  /**
+   * @brief This function returns the number of frames sent but not yet done
+   */
+  std::size_t queued_frames() const noexcept { return this->pending_tags_.size(); }
+
+  /**
+   * @brief This function returns the number of points waiting to be sent
+   */
+  std::size_t buffered_points() const noexcept { return this->samples_.size(); }
+
+ private:
+  Options options_;
+  detail::SpscQueue<PVTSample, CAPACITY> samples_;
+  std::atomic<bool> finished_{false};
+  std::atomic<State> state_{State::Idle};
+
+  std::deque<int> pending_tags_; /*!< tags of the frames not yet done, oldest first */
+  int next_tag_     = 1;
+  bool query_sent_  = false; /*!< QueueTagDone sent, waiting for its response */
+  std::chrono::steady_clock::time_point last_query_{};
+
+  motion_function::BaseHeaderProductPtr next_batch() noexcept;
+  motion_function::BaseHeaderProductPtr next_query() noexcept;
+};
+
+}  // namespace tm_robot_listener
+
+#endif
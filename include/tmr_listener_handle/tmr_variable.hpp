@@ -1,18 +1,34 @@
 #ifndef TMR_VARIABLE_HPP_
 #define TMR_VARIABLE_HPP_
 
+#include "tm_robot_listener/detail/tmr_constexpr_string.hpp"
 #include "tm_robot_listener/detail/tmr_fundamental_type.hpp"
 #include "tm_robot_listener/detail/tmr_fwd.hpp"
 #include "tm_robot_listener/detail/tmr_mt_helper.hpp"
 #include "tm_robot_listener/detail/tmr_operator.hpp"
 #include "tm_robot_listener/detail/tmr_stringifier.hpp"
 
-#include <boost/format.hpp>
 #include <boost/fusion/include/at_key.hpp>
 #include <stdexcept>
 #include <string>
 #include <type_traits>
 
+/**
+ * @brief This macro creates VarName from a string literal, the name is validated at compile time
+ *
+ * @code{.cpp}
+ *
+ *    Variable<int> counter{TMR_VAR_NAME("counter")};
+ *    Variable<int> first{TMR_VAR_NAME("1st")};  // compile error
+ *
+ * @endcode
+ */
+#define TMR_VAR_NAME(NAME)                                     \
+  ([]() {                                                      \
+    constexpr ::tm_robot_listener::VarName tmr_var_name{NAME}; \
+    return tmr_var_name;                                       \
+  }())
+
 namespace tm_robot_listener {
 
 /**
@@ -21,10 +37,15 @@ namespace tm_robot_listener {
  *        their operands, that specifies a computation. In tmr_listener, operands can be @ref Variable or r-value. This
  *        is used for message generation, see example
  *
- * @tparam T  Result type of the expression evaluation
+ * @tparam T    Result type of the expression evaluation
+ * @tparam Node Root of the expression tree, operators keep their operands in a typed tree instead of concatenating
+ *              strings, the tree is rendered once when the expression is appended to a script. Expression<T> holds a
+ *              rendered string, any expression of type T converts to it, e.g., to be stored in a container.
+ *
+ * @note  The tree refers to its Variable operands instead of copying their names, the Variables must outlive the
+ *        expression unless it is converted to Expression<T>
  *
  * @todo make the constructor private, and only friend Variable
- * @note  Consider making it constexpr constructible
  *
  * @code{.cpp}
  *
@@ -34,16 +55,50 @@ namespace tm_robot_listener {
  *
  * @endcode
  */
-template <typename T>
+template <typename T, typename Node>
 struct Expression {
   using underlying_t = T;
 
-  std::string const value;  // @note this variable is marked as const as I didn't make the construction and variable
-                            // private, make it at least unmodifiable
-  auto operator()() const noexcept { return this->value; }
+  Node node_;
+
+  /**
+   * @brief This function renders the expression
+   */
+  std::string operator()() const noexcept {
+    std::string ret_val;
+    this->render(ret_val);
+    return ret_val;
+  }
+
+  /**
+   * @brief This function appends the rendered expression to t_out
+   */
+  void render(std::string& t_out) const noexcept { this->node_.render(t_out); }
+
+  template <typename U = Node, std::enable_if_t<not std::is_same<U, detail::RenderedNode>::value, bool> = true>
+  operator Expression<T>() const noexcept {  // NOLINT
+    return Expression<T>{detail::RenderedNode{(*this)()}};
+  }
 };
 
-TM_DEFINE_OPERATORS(Expression)
+/**
+ * @brief Name of TM variable, a literal name is validated at compile time when it is used in constant expression, see
+ *        TMR_VAR_NAME, otherwise std::invalid_argument is thrown on construction
+ */
+class VarName {
+ private:
+  detail::ConstString name_;
+
+ public:
+  template <std::size_t N>
+  explicit constexpr VarName(char const (&t_name)[N]) : name_{t_name} {
+    if (not detail::is_valid_var_name(t_name, t_name + N - 1)) {
+      throw std::invalid_argument{"bad variable name"};
+    }
+  }
+
+  std::string to_std_str() const noexcept { return this->name_.to_std_str(); }
+};
 
 /**
  * @brief The class represents the concept of named variable in TM external script language, for more information, refer
@@ -58,15 +113,30 @@ class Variable {  // NOLINT
  private:
   std::string const name_;  // @note this variable is marked as const as I didn't make the construction and variable
                             // private, make it at least unmodifiable
+  bool const name_checked_ = false; /*!< name is validated already, see VarName */
+
  public:
   using underlying_t = T;
 
   Variable() = delete;  // nobody should default construct a Variable instance, doing so is meaningless
   explicit Variable(std::string t_name) noexcept : name_(std::move(t_name)) {}  // copy and move idiom
+  explicit Variable(VarName const& t_name) noexcept : name_(t_name.to_std_str()), name_checked_{true} {}
+  Variable(Variable const&) = default;  // Expression refers to its Variable operands, see detail::VariableRef
+  Variable(Variable&&) noexcept = default;
   // explicit constexpr Variable() noexcept : {}
 
   auto operator()() const noexcept { return this->name_; }
 
+  /**
+   * @brief This function checks whether the name can be declared, the name given by VarName is not scanned again
+   */
+  bool valid_name() const noexcept { return this->name_checked_ or detail::is_valid_var_name(this->name_); }
+
+  /**
+   * @brief This function appends the name to t_out, see Expression::render
+   */
+  void render(std::string& t_out) const noexcept { t_out.append(this->name_); }
+
   /**
    * @brief operator= overloading for assignment expression
    *
@@ -81,11 +151,8 @@ class Variable {  // NOLINT
   [[gnu::warn_unused_result]] auto operator=(U const& t_input) noexcept {  // NOLINT
     static_assert(std::is_convertible<typename detail::RealType<U>::type, T>::value,
                   "No known conversion from input type to Variable underlying type");
-    // clang-format off
-    using stringifier = std::conditional_t<detail::is_expression<U> or detail::is_named_var<U>,
-                                           detail::statement_to_string, value_to_string<U>>;
-    // clang-format on
-    return Expression<T>{'(' + this->name_ + '=' + stringifier{}(t_input) + ')'};
+    using node_t = detail::BinaryNode<detail::VariableRef<Variable>, detail::operand_t<U>>;
+    return Expression<T, node_t>{node_t{"=", detail::make_operand(*this), detail::make_operand(t_input)}};
   }
 
   /**
@@ -101,7 +168,8 @@ class Variable {  // NOLINT
    *       assignment didn't do what it "normally" should do.
    */
   [[gnu::warn_unused_result]] auto operator=(Variable<T> const& t_input) noexcept {  // NOLINT
-    return Expression<T>{'(' + this->name_ + '=' + t_input() + ')'};
+    using node_t = detail::BinaryNode<detail::VariableRef<Variable>, detail::VariableRef<Variable>>;
+    return Expression<T, node_t>{node_t{"=", detail::make_operand(*this), detail::make_operand(t_input)}};
   }
 
   [[gnu::warn_unused_result]] auto operator[](std::size_t const t_index) const noexcept {
@@ -113,7 +181,7 @@ class Variable {  // NOLINT
   }
 };
 
-TM_DEFINE_OPERATORS(Variable)
+TM_DEFINE_OPERATORS()
 
 template <typename S, typename T, typename U, typename V>
 [[gnu::warn_unused_result]] inline auto ternary_expr(T const& t_expr, U const& t_left, V const& t_right) noexcept {
@@ -131,7 +199,9 @@ template <typename S, typename T, typename U, typename V>
   static_assert(right_type_require and right_u_type_require,
                 "Expression or Variable must be convertible to the underlying type of the Variable");
 
-  return Expression<S>{'(' + t_expr() + '?' + t_left() + ':' + t_right() + ')'};
+  using node_t = detail::TernaryNode<detail::operand_t<T>, detail::operand_t<U>, detail::operand_t<V>>;
+  return Expression<S, node_t>{
+    node_t{detail::make_operand(t_expr), detail::make_operand(t_left), detail::make_operand(t_right)}};
 }
 
 /**
@@ -145,14 +215,13 @@ template <typename S, typename T, typename U, typename V>
 template <typename T, /*typename U,*/ std::enable_if_t<tmr_mt_helper::is_std_array<T>::value, bool> = true>
 [[gnu::warn_unused_result]] inline auto declare(Variable<T> const& t_var, T const& t_val) {
   // static_assert(); U must be one of the following: T, or underlying type of U that is convertible to T
-  if (not boost::xpressive::regex_match(t_var(), detail::var_name_pattern())) {
+  if (not t_var.valid_name()) {
     throw std::invalid_argument{"bad variable name: " + t_var()};
   }
 
-  using namespace boost::fusion;
   constexpr auto type_decl = motion_function::detail::get_type_decl_str<typename T::value_type>();
-  auto const formatted = boost::format("%s[] %s=%s") % type_decl.to_std_str() % t_var() % value_to_string<T>{}(t_val);
-  return Expression<T>{formatted.str()};
+  using node_t             = detail::DeclarationNode<Variable<T>, detail::Literal<T>>;
+  return Expression<T, node_t>{node_t{type_decl.name_, true, t_var, detail::Literal<T>{t_val}}};
 }
 
 /**
@@ -168,14 +237,13 @@ template <typename T, /*typename U,*/ std::enable_if_t<tmr_mt_helper::is_std_arr
 template <typename T, /*typename U,*/ std::enable_if_t<not tmr_mt_helper::is_std_array<T>::value, bool> = true>
 [[gnu::warn_unused_result]] inline auto declare(Variable<T> const& t_var, T const& t_val) {
   // static_assert();
-  if (not boost::xpressive::regex_match(t_var(), detail::var_name_pattern())) {
+  if (not t_var.valid_name()) {
     throw std::invalid_argument{"bad variable name: " + t_var()};
   }
 
-  using namespace boost::fusion;
   constexpr auto type_decl = motion_function::detail::get_type_decl_str<T>();
-  auto const formatted     = boost::format("%s %s=%s") % type_decl.to_std_str() % t_var() % value_to_string<T>{}(t_val);
-  return Expression<T>{formatted.str()};
+  using node_t             = detail::DeclarationNode<Variable<T>, detail::Literal<T>>;
+  return Expression<T, node_t>{node_t{type_decl.name_, false, t_var, detail::Literal<T>{t_val}}};
 }
 
 /**
@@ -191,13 +259,13 @@ template <typename T, /*typename U,*/ std::enable_if_t<not tmr_mt_helper::is_std
 template <typename T, /*typename U,*/ std::enable_if_t<tmr_mt_helper::is_std_array<T>::value, bool> = true>
 [[gnu::warn_unused_result]] inline auto declare(Variable<T> const& t_var, Variable<T> const& t_val) {
   // static_assert();
-  if (not boost::xpressive::regex_match(t_var(), detail::var_name_pattern())) {
+  if (not t_var.valid_name()) {
     throw std::invalid_argument{"bad variable name: " + t_var()};
   }
 
   constexpr auto type_decl = motion_function::detail::get_type_decl_str<typename T::value_type>();
-  auto const formatted     = boost::format("%s[] %s=%s") % type_decl.to_std_str() % t_var() % t_val();
-  return Expression<T>{formatted.str()};
+  using node_t             = detail::DeclarationNode<Variable<T>, Variable<T>>;
+  return Expression<T, node_t>{node_t{type_decl.name_, true, t_var, t_val}};
 }
 
 /**
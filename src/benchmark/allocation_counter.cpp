@@ -0,0 +1,18 @@
+#include <cstdlib>
+#include <new>
+
+#include "allocation_counter.hpp"
+
+std::atomic<std::size_t> allocation_count{0};
+
+void* operator new(std::size_t t_size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  if (auto* const ret_val = std::malloc(t_size == 0 ? 1 : t_size)) {
+    return ret_val;
+  }
+
+  throw std::bad_alloc{};
+}
+
+void operator delete(void* t_ptr) noexcept { std::free(t_ptr); }
+void operator delete(void* t_ptr, std::size_t /*unused*/) noexcept { std::free(t_ptr); }
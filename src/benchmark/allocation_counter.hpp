@@ -0,0 +1,37 @@
+#ifndef TMR_ALLOCATION_COUNTER_HPP_
+#define TMR_ALLOCATION_COUNTER_HPP_
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <cstddef>
+
+/**
+ * @brief Number of calls to global operator new so far, the replacement lives in allocation_counter.cpp, in its own
+ *        translation unit so that the compiler can't see through it
+ */
+extern std::atomic<std::size_t> allocation_count;
+
+/**
+ * @brief This class reports allocations per iteration, counting starts on construction and ends on destruction
+ */
+class AllocationCounter {
+ private:
+  benchmark::State& state_;
+  std::size_t start_;
+
+ public:
+  explicit AllocationCounter(benchmark::State& t_state) noexcept
+    : state_{t_state}, start_{allocation_count.load(std::memory_order_relaxed)} {}
+
+  AllocationCounter(AllocationCounter const& /*unused*/) = delete;
+  AllocationCounter& operator=(AllocationCounter const& /*unused*/) = delete;
+
+  ~AllocationCounter() {
+    auto const allocations = allocation_count.load(std::memory_order_relaxed) - this->start_;
+    this->state_.counters["allocs/op"] =
+      benchmark::Counter(static_cast<double>(allocations), benchmark::Counter::kAvgIterations);
+  }
+};
+
+#endif
@@ -0,0 +1,140 @@
+#include <benchmark/benchmark.h>
+
+#include "allocation_counter.hpp"
+#include "tmr_listener_handle/tmr_listener_handle.hpp"
+
+namespace {
+
+class NullHandle final : public tm_robot_listener::ListenerHandle {
+ protected:
+  tm_robot_listener::Decision start_task(std::vector<std::string> const& /*unused*/) override {
+    return tm_robot_listener::Decision::Accept;
+  }
+
+  tm_robot_listener::motion_function::BaseHeaderProductPtr generate_cmd(MessageStatus const /*unused*/) override {
+    return tm_robot_listener::motion_function::empty_command_list();
+  }
+};
+
+}  // namespace
+
+static void BM_TMSCTBuild(benchmark::State& t_state) {
+  using namespace tm_robot_listener;
+  using namespace tm_robot_listener::motion_function;
+  using namespace std::string_literals;
+
+  Variable<std::array<float, 6>> target{"target"};
+  AllocationCounter counter{t_state};
+  for (auto _ : t_state) {
+    auto const command = TMSCT << ID{"1"} << declare(target, std::array<float, 6>{205, -35, 125, 0, 90, 0})
+                               << PTP("JPP"s, target, 10, 200, 0, false) << QueueTag(1) << End();
+    benchmark::DoNotOptimize(command);
+  }
+}
+BENCHMARK(BM_TMSCTBuild);
+
+static void BM_TMSCTToStr(benchmark::State& t_state) {
+  using namespace tm_robot_listener;
+  using namespace tm_robot_listener::motion_function;
+  using namespace std::string_literals;
+
+  Variable<std::array<float, 6>> target{"target"};
+  auto const command = TMSCT << ID{"1"} << declare(target, std::array<float, 6>{205, -35, 125, 0, 90, 0})
+                             << PTP("JPP"s, target, 10, 200, 0, false) << QueueTag(1) << End();
+
+  AllocationCounter counter{t_state};
+  for (auto _ : t_state) {
+    auto const frame = command->to_str();
+    benchmark::DoNotOptimize(frame.data());
+  }
+}
+BENCHMARK(BM_TMSCTToStr);
+
+static void BM_PoseToString(benchmark::State& t_state) {
+  using namespace tm_robot_listener;
+
+  std::array<float, 6> const pose{417.5F, -122.25F, 365.125F, 180, 0.1F, 90};
+  AllocationCounter counter{t_state};
+  for (auto _ : t_state) {
+    auto const text = value_to_string<std::array<float, 6>>{}(pose);
+    benchmark::DoNotOptimize(text.data());
+  }
+}
+BENCHMARK(BM_PoseToString);
+
+static void BM_HandleResponse(benchmark::State& t_state, char const* t_frame) {
+  NullHandle handle;
+  auto const frame = tm_robot_listener::parse_frame(t_frame);
+
+  AllocationCounter counter{t_state};
+  for (auto _ : t_state) {
+    benchmark::DoNotOptimize(handle.handle_response(frame));
+  }
+}
+BENCHMARK_CAPTURE(BM_HandleResponse, TMSCT, "$TMSCT,13,3,ERROR;1;2;3,*3F\r\n");
+BENCHMARK_CAPTURE(BM_HandleResponse, TMSTA, "$TMSTA,15,00,true,Listen1,*79\r\n");
+BENCHMARK_CAPTURE(BM_HandleResponse, CPERR, "$CPERR,2,04,*4C\r\n");
+
+static void BM_ParseFrame(benchmark::State& t_state) {
+  AllocationCounter counter{t_state};
+  for (auto _ : t_state) {
+    auto const frame = tm_robot_listener::parse_frame("$TMSCT,13,3,ERROR;1;2;3,*3F\r\n");
+    benchmark::DoNotOptimize(frame.error_);
+  }
+}
+BENCHMARK(BM_ParseFrame);
+
+static void BM_Declare(benchmark::State& t_state) {
+  using namespace tm_robot_listener;
+
+  Variable<std::array<float, 6>> target{"target"};
+  AllocationCounter counter{t_state};
+  for (auto _ : t_state) {
+    auto const expr = declare(target, std::array<float, 6>{205, -35, 125, 0, 90, 0});
+    benchmark::DoNotOptimize(expr);
+  }
+}
+BENCHMARK(BM_Declare);
+
+static void BM_ExpressionBuild(benchmark::State& t_state) {
+  using namespace tm_robot_listener;
+
+  // names beyond the small string buffer, as in real scripts, so that copying a name would show up as allocation
+  Variable<int> pick_count{"conveyor_pick_count"};
+  Variable<int> place_count{"conveyor_place_count"};
+  Variable<float> offset{"conveyor_pick_offset_x"};
+  AllocationCounter counter{t_state};
+  for (auto _ : t_state) {
+    auto const expr = ternary_expr<int>(pick_count == 1, pick_count + place_count, offset + pick_count);
+    benchmark::DoNotOptimize(expr());
+  }
+}
+BENCHMARK(BM_ExpressionBuild);
+
+static void BM_ExpressionScript(benchmark::State& t_state) {
+  using namespace tm_robot_listener;
+  using namespace tm_robot_listener::motion_function;
+
+  Variable<int> a{"conveyor_pick_count"};
+  Variable<int> b{"conveyor_place_count"};
+  Variable<float> c{"conveyor_pick_offset_x"};
+  Variable<float> d{"conveyor_place_offset_x"};
+  AllocationCounter counter{t_state};
+  for (auto _ : t_state) {
+    auto const command = TMSCT << ID{"1"} << (d = (a + b) * c - 0.5F) << ((a + b) * c == d) << (a += b * 2) << End();
+    benchmark::DoNotOptimize(command);
+  }
+}
+BENCHMARK(BM_ExpressionScript);
+
+static void BM_CalculateChecksum(benchmark::State& t_state) {
+  std::string const frame{"$TMSCT,64,2,ChangeBase(\"RobotBase\")\r\nChangeTCP(\"NOTOOL\")\r\nChangeLoad(10.1),"};
+
+  AllocationCounter counter{t_state};
+  for (auto _ : t_state) {
+    benchmark::DoNotOptimize(tm_robot_listener::motion_function::calculate_checksum(frame));
+  }
+}
+BENCHMARK(BM_CalculateChecksum);
+
+BENCHMARK_MAIN();
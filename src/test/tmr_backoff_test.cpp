@@ -0,0 +1,55 @@
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include "tm_robot_listener/detail/tmr_backoff.hpp"
+
+using tm_robot_listener::detail::Backoff;
+using std::chrono::milliseconds;
+
+TEST(BackoffTest, ExponentialGrowth) {
+  Backoff backoff{milliseconds{100}, milliseconds{1000}, 2.0, 0.0};
+  std::minstd_rand rng;
+
+  std::vector<Backoff::Duration> delays;
+  for (int i = 0; i < 6; ++i) {
+    delays.push_back(backoff.next_delay(rng));
+  }
+
+  EXPECT_EQ(delays, (std::vector<Backoff::Duration>{milliseconds{100}, milliseconds{200}, milliseconds{400},
+                                                    milliseconds{800}, milliseconds{1000}, milliseconds{1000}}));
+
+  backoff.reset();
+  EXPECT_EQ(backoff.next_delay(rng), milliseconds{100});
+}
+
+TEST(BackoffTest, JitterWithinBounds) {
+  Backoff backoff{milliseconds{100}, milliseconds{100}, 2.0, 0.5};
+  std::minstd_rand rng;
+
+  auto shortest = Backoff::Duration::max();
+  auto longest  = Backoff::Duration::zero();
+  for (int i = 0; i < 1000; ++i) {
+    auto const delay = backoff.next_delay(rng);
+    shortest         = std::min(shortest, delay);
+    longest          = std::max(longest, delay);
+  }
+
+  EXPECT_GE(shortest, milliseconds{50});
+  EXPECT_LT(shortest, milliseconds{90});  // spread, not always the same delay
+  EXPECT_LE(longest, milliseconds{100});  // never beyond the maximum delay
+}
+
+TEST(BackoffTest, Sanitized) {
+  Backoff backoff{milliseconds{0}, milliseconds{0}, 0.5, -1.0};
+  std::minstd_rand rng;
+
+  EXPECT_EQ(backoff.next_delay(rng), milliseconds{1});
+  EXPECT_EQ(backoff.next_delay(rng), milliseconds{1});
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "tm_robot_listener/detail/tmr_frame_log.hpp"
+
+TEST(FrameLogTest, PushDrain) {
+  using FrameLog_t = tm_robot_listener::FrameLog<4, 18>;
+  FrameLog_t log;
+
+  EXPECT_TRUE(log.push(FrameLog_t::Direction::Received, "$TMSTA,10,01,08,true,*6D\r\n"));
+  EXPECT_TRUE(log.push(FrameLog_t::Direction::Sent, "$TMSTA,2,00,*41\r\n"));
+
+  std::vector<std::string> frames;
+  auto const drained = log.drain([&frames](FrameLog_t::Entry const& t_entry) {
+    frames.emplace_back(t_entry.frame().to_string() + (t_entry.truncated() ? "..." : ""));
+  });
+
+  EXPECT_EQ(drained, 2);
+  ASSERT_EQ(frames.size(), 2);
+  EXPECT_EQ(frames[0], "$TMSTA,10,01,08,tr...");
+  EXPECT_EQ(frames[1], "$TMSTA,2,00,*41");
+  EXPECT_EQ(log.drain([](FrameLog_t::Entry const& /*unused*/) {}), 0);
+}
+
+TEST(FrameLogTest, DropWhenFull) {
+  using FrameLog_t = tm_robot_listener::FrameLog<2, 16>;
+  FrameLog_t log;
+
+  EXPECT_TRUE(log.push(FrameLog_t::Direction::Received, "1"));
+  EXPECT_TRUE(log.push(FrameLog_t::Direction::Received, "2"));
+  EXPECT_FALSE(log.push(FrameLog_t::Direction::Received, "3"));
+  EXPECT_EQ(log.take_dropped(), 1);
+  EXPECT_EQ(log.take_dropped(), 0);
+
+  std::string frames;
+  log.drain([&frames](FrameLog_t::Entry const& t_entry) { frames += t_entry.frame().to_string(); });
+  EXPECT_EQ(frames, "12");
+
+  EXPECT_TRUE(log.push(FrameLog_t::Direction::Received, "4"));
+}
+
+TEST(FrameLogTest, ConcurrentProducerConsumer) {
+  using FrameLog_t = tm_robot_listener::FrameLog<8, 16>;
+  FrameLog_t log;
+
+  constexpr int FRAME_COUNT = 10000;
+  std::thread producer{[&log]() {
+    for (int i = 0; i < FRAME_COUNT;) {
+      if (log.push(FrameLog_t::Direction::Sent, std::to_string(i))) {
+        ++i;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  }};
+
+  int expected = 0;
+  while (expected < FRAME_COUNT) {
+    log.drain([&expected](FrameLog_t::Entry const& t_entry) {
+      EXPECT_EQ(t_entry.frame(), std::to_string(expected));
+      ++expected;
+    });
+    std::this_thread::yield();
+  }
+
+  producer.join();
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
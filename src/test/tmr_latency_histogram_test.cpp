@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+
+#include "tm_robot_listener/detail/tmr_latency_histogram.hpp"
+
+using tm_robot_listener::detail::LatencyHistogram;
+using std::chrono::nanoseconds;
+
+static constexpr nanoseconds MAX_LATENCY{nanoseconds::rep{LatencyHistogram::MAX_VALUE}};
+
+TEST(LatencyHistogramTest, Percentile) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(histogram.count(), 0U);
+  EXPECT_EQ(histogram.percentile(0.5), nanoseconds::zero());
+
+  for (int i = 1; i <= 100; ++i) {
+    histogram.record(std::chrono::microseconds{i});
+  }
+
+  EXPECT_EQ(histogram.count(), 100U);
+  EXPECT_EQ(histogram.max(), std::chrono::microseconds{100});
+  EXPECT_EQ(histogram.mean(), nanoseconds{50500});
+
+  // the buckets are 1 / 32 wide relative to their magnitude, the highest value of the bucket is reported
+  auto const within_bucket = [](nanoseconds const t_reported, nanoseconds const t_expected) {
+    return t_reported >= t_expected and t_reported.count() <= t_expected.count() + t_expected.count() / 32;
+  };
+  EXPECT_TRUE(within_bucket(histogram.percentile(0.5), std::chrono::microseconds{50}));
+  EXPECT_TRUE(within_bucket(histogram.percentile(0.99), std::chrono::microseconds{99}));
+  EXPECT_EQ(histogram.percentile(1.0), std::chrono::microseconds{100});
+}
+
+TEST(LatencyHistogramTest, ExactBelowSubBucketCount) {
+  LatencyHistogram histogram;
+  for (std::uint64_t i = 0; i < 2 * LatencyHistogram::SUB_BUCKET_COUNT; ++i) {
+    histogram.record(nanoseconds{i});
+  }
+
+  EXPECT_EQ(histogram.percentile(0.5), nanoseconds{31});
+  EXPECT_EQ(histogram.percentile(1.0), nanoseconds{63});
+}
+
+TEST(LatencyHistogramTest, ClampAndMerge) {
+  LatencyHistogram lhs;
+  LatencyHistogram rhs;
+  lhs.record(nanoseconds{-5});
+  rhs.record(std::chrono::hours{24});
+
+  lhs.merge(rhs);
+  EXPECT_EQ(lhs.count(), 2U);
+  EXPECT_EQ(lhs.percentile(0.5), nanoseconds::zero());
+  EXPECT_EQ(lhs.max(), MAX_LATENCY);
+  EXPECT_EQ(lhs.percentile(1.0), MAX_LATENCY);
+
+  lhs.reset();
+  EXPECT_EQ(lhs.count(), 0U);
+  EXPECT_EQ(lhs.max(), nanoseconds::zero());
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
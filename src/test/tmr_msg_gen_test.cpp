@@ -1,4 +1,5 @@
 #include <gtest/gtest.h>
+#include <limits>
 
 #include "tmr_listener_handle/tmr_motion_function.hpp"
 
@@ -41,12 +42,18 @@ TEST(ChecksumTest, ChecksumStringMatch) {
             "49");
 }
 
+/**
+ * @brief Expression<T> that an expression tree of type T converts to, operators yield trees of different node types
+ */
+template <typename Expr>
+using erased_t = tm_robot_listener::Expression<typename Expr::underlying_t>;
+
 #define EXPECT(TYPE) Expression<TYPE>
-#define VARIABLE_BINARY_OP_TEST(VAR_1, OP, VAR_2, RESULT_TYPE)                                        \
-  {                                                                                                   \
-    auto expr = VAR_1 OP VAR_2;                                                                       \
-    static_assert(std::is_same<decltype(expr), RESULT_TYPE>::value, "Expression type doesn't match"); \
-    EXPECT_EQ(expr(), "(" #VAR_1 #OP #VAR_2 ")");                                                     \
+#define VARIABLE_BINARY_OP_TEST(VAR_1, OP, VAR_2, RESULT_TYPE)                                                  \
+  {                                                                                                             \
+    auto expr = VAR_1 OP VAR_2;                                                                                 \
+    static_assert(std::is_same<erased_t<decltype(expr)>, RESULT_TYPE>::value, "Expression type doesn't match"); \
+    EXPECT_EQ(expr(), "(" #VAR_1 #OP #VAR_2 ")");                                                               \
   }
 
 TEST(VariableTest, BinaryOperator) {
@@ -80,41 +87,60 @@ TEST(VariableTest, UnaryOperator) {
 
   {
     auto expr = int_var++;
-    static_assert(std::is_same<decltype(expr), Expression<int>>::value, "Expression type doesn't match");
+    static_assert(std::is_same<erased_t<decltype(expr)>, Expression<int>>::value, "Expression type doesn't match");
     EXPECT_EQ(expr(), "(int_var++)");
   }
 
   {
     auto expr = ++int_var;
-    static_assert(std::is_same<decltype(expr), Expression<int>>::value, "Expression type doesn't match");
+    static_assert(std::is_same<erased_t<decltype(expr)>, Expression<int>>::value, "Expression type doesn't match");
     EXPECT_EQ(expr(), "(++int_var)");
   }
 
   {
     auto expr = !bool_var;
-    static_assert(std::is_same<decltype(expr), Expression<bool>>::value, "Expression type doesn't match");
+    static_assert(std::is_same<erased_t<decltype(expr)>, Expression<bool>>::value, "Expression type doesn't match");
     EXPECT_EQ(expr(), "(!bool_var)");
   }
 
   {
     auto expr = ~int_var;
-    static_assert(std::is_same<decltype(expr), Expression<int>>::value, "Expression type doesn't match");
+    static_assert(std::is_same<erased_t<decltype(expr)>, Expression<int>>::value, "Expression type doesn't match");
     EXPECT_EQ(expr(), "(~int_var)");
   }
 
   {
     auto expr = -int_var;
-    static_assert(std::is_same<decltype(expr), Expression<int>>::value, "Expression type doesn't match");
+    static_assert(std::is_same<erased_t<decltype(expr)>, Expression<int>>::value, "Expression type doesn't match");
     EXPECT_EQ(expr(), "(-int_var)");
   }
 
   {
     auto expr = +int_var;
-    static_assert(std::is_same<decltype(expr), Expression<int>>::value, "Expression type doesn't match");
+    static_assert(std::is_same<erased_t<decltype(expr)>, Expression<int>>::value, "Expression type doesn't match");
     EXPECT_EQ(expr(), "(+int_var)");
   }
 }
 
+TEST(VariableTest, VariableName) {
+  using namespace tm_robot_listener;
+
+  static_assert(detail::is_valid_var_name("_var_1", "_var_1" + 6), "valid name is rejected");
+  static_assert(not detail::is_valid_var_name("1_var", "1_var" + 5), "invalid name is accepted");
+  static_assert(not detail::is_valid_var_name("", "" + 0), "empty name is accepted");
+
+  Variable<int> const counter{TMR_VAR_NAME("counter")};
+  EXPECT_EQ(declare(counter, 1)(), "int counter=1");
+
+  EXPECT_THROW(VarName{"var-1"}, std::invalid_argument);  // not constant expression, validated at runtime
+  Variable<int> const with_space{"var 1"};
+  Variable<int> const empty{""};
+  Variable<float> const runtime{"Var_1"};
+  EXPECT_THROW(declare(with_space, 1), std::invalid_argument);
+  EXPECT_THROW(declare(empty, 1), std::invalid_argument);
+  EXPECT_EQ(declare(runtime, 1.5F)(), "float Var_1=1.5");
+}
+
 TEST(ExpressionTest, BinaryOperator) {
   using namespace tm_robot_listener;
 
@@ -128,32 +154,36 @@ TEST(ExpressionTest, BinaryOperator) {
 
   {
     auto add_two_int_expr = int_expr + other_int_expr;
-    static_assert(std::is_same<decltype(add_two_int_expr), Expression<int>>::value, "Expression type doesn't match");
+    static_assert(std::is_same<erased_t<decltype(add_two_int_expr)>, Expression<int>>::value,
+                  "Expression type doesn't match");
     EXPECT_EQ(add_two_int_expr(), "((int_var+other_int)+(int_var+1))");
   }
 
   {  // expression with different type
     auto add_int_to_float_expr = int_expr + float_expr;
-    static_assert(std::is_same<decltype(add_int_to_float_expr), Expression<float>>::value,
+    static_assert(std::is_same<erased_t<decltype(add_int_to_float_expr)>, Expression<float>>::value,
                   "Expression type doesn't match");
     EXPECT_EQ(add_int_to_float_expr(), "((int_var+other_int)+(int_var+float_var))");
   }
 
   {  // expression + r-value
     auto add_int_expr = int_expr + 1;
-    static_assert(std::is_same<decltype(add_int_expr), Expression<int>>::value, "Expression type doesn't match");
+    static_assert(std::is_same<erased_t<decltype(add_int_expr)>, Expression<int>>::value,
+                  "Expression type doesn't match");
     EXPECT_EQ(add_int_expr(), "((int_var+other_int)+1)");
   }
 
   {  // expression + variable
     auto add_int_expr = int_expr + int_var;
-    static_assert(std::is_same<decltype(add_int_expr), Expression<int>>::value, "Expression type doesn't match");
+    static_assert(std::is_same<erased_t<decltype(add_int_expr)>, Expression<int>>::value,
+                  "Expression type doesn't match");
     EXPECT_EQ(add_int_expr(), "((int_var+other_int)+int_var)");
   }
 
   {  // variable + expression
     auto add_int_expr = int_var + int_expr;
-    static_assert(std::is_same<decltype(add_int_expr), Expression<int>>::value, "Expression type doesn't match");
+    static_assert(std::is_same<erased_t<decltype(add_int_expr)>, Expression<int>>::value,
+                  "Expression type doesn't match");
     EXPECT_EQ(add_int_expr(), "(int_var+(int_var+other_int))");
   }
 
@@ -161,15 +191,45 @@ TEST(ExpressionTest, BinaryOperator) {
     Variable<bool> bool_var{"bool_var"};
 
     auto tern_expr_3_var = ternary_expr<int>(bool_var, int_var, float_var);
-    static_assert(std::is_same<decltype(tern_expr_3_var), Expression<int>>::value, "Expression type doesn't match");
+    static_assert(std::is_same<erased_t<decltype(tern_expr_3_var)>, Expression<int>>::value,
+                  "Expression type doesn't match");
     EXPECT_EQ(tern_expr_3_var(), "(bool_var?int_var:float_var)");
 
     auto tern_expr_3_expr = ternary_expr<int>(int_var == 1, int_var + other_int, float_var + int_var);
-    static_assert(std::is_same<decltype(tern_expr_3_expr), Expression<int>>::value, "Expression type doesn't match");
+    static_assert(std::is_same<erased_t<decltype(tern_expr_3_expr)>, Expression<int>>::value,
+                  "Expression type doesn't match");
     EXPECT_EQ(tern_expr_3_expr(), "((int_var==1)?(int_var+other_int):(float_var+int_var))");
   }
 }
 
+TEST(ExpressionTest, ExpressionTree) {
+  using namespace tm_robot_listener;
+  using namespace tm_robot_listener::motion_function;
+
+  Variable<int> a{"a"};
+  Variable<int> b{"b"};
+  Variable<float> c{"c"};
+  Variable<float> d{"d"};
+
+  auto const cond = (a + b) * c == d;
+  static_assert(std::is_same<erased_t<decltype(cond)>, Expression<bool>>::value, "Expression type doesn't match");
+  EXPECT_EQ(cond(), "(((a+b)*c)==d)");
+
+  {  // rendered in place, same as appending the rendered string
+    Expression<float> const assign = (d = c * 0.5F);
+    Expression<bool> const erased  = cond;
+    auto const command             = TMSCT << ID{"1"} << (d = c * 0.5F) << cond << End();
+    auto const expected            = TMSCT << ID{"1"} << assign << erased << End();
+    EXPECT_EQ(command->to_str(), expected->to_str());
+    EXPECT_EQ(command->to_str(), "$TMSCT,29,1,(d=(c*0.5))\r\n(((a+b)*c)==d),*5F\r\n");
+  }
+
+  {  // sub-expressions are kept by value
+    auto const tree = ternary_expr<float>(a == 1, a + 1, c - 2.5);
+    EXPECT_EQ(tree(), "((a==1)?(a+1):(c-2.5))");
+  }
+}
+
 TEST(TMMsgGen, StringMatch) {
   using namespace tm_robot_listener::motion_function;
   using namespace std::string_literals;
@@ -201,6 +261,147 @@ TEST(TMMsgGen, StringMatch) {
               "PTP(\"JPP\",targetP2,10,200,10,false)\r\n"
               "QueueTag(2),*54\r\n");
   }
+
+  {
+    auto const command = TMSCT << ID{"1"} << ScriptExit();
+    std::string buffer{"$TMSTA,2,00,*41\r\n"};
+    command->serialize(buffer);
+    EXPECT_EQ(buffer, "$TMSTA,2,00,*41\r\n$TMSCT,14,1,ScriptExit(),*" +
+                        calculate_checksum("$TMSCT,14,1,ScriptExit(),") + "\r\n");
+    EXPECT_EQ(empty_command_list()->to_str(), "");
+  }
+}
+
+TEST(TMMsgGen, CachedFrame) {
+  using namespace tm_robot_listener::motion_function;
+
+  auto const generate = []() { return cached_frame([] { return TMSTA << InExtScriptCtlMode() << End(); }); };
+  auto const command  = generate();
+
+  EXPECT_EQ(command, generate());  // rendered only once
+  EXPECT_EQ(command->to_str(), (TMSTA << InExtScriptCtlMode() << End())->to_str());
+  EXPECT_EQ(command->prebuilt_frame(), command->to_str());
+  EXPECT_EQ(command->header(), "$TMSTA");
+  EXPECT_EQ(command->response_key(), "00");
+  EXPECT_FALSE(command->has_script_exit());
+
+  auto const exit = cached_frame([] { return TMSCT << ID{"Exit"} << ScriptExit(); });
+  EXPECT_TRUE(exit->has_script_exit());
+  EXPECT_EQ(exit->response_key(), "Exit");
+
+  std::string buffer{"$TMSTA,2,00,*41\r\n"};
+  exit->serialize(buffer);
+  EXPECT_EQ(buffer, "$TMSTA,2,00,*41\r\n" + exit->to_str());
+  EXPECT_TRUE((TMSCT << ID{"1"} << End())->prebuilt_frame().empty());
+}
+
+TEST(TMMsgGen, RawFrame) {
+  using namespace tm_robot_listener::motion_function;
+
+  auto const complete = raw_frame("$TMSCT,8,1,Exit(),*75");
+  EXPECT_EQ(complete->prebuilt_frame(), "$TMSCT,8,1,Exit(),*75\r\n");
+  EXPECT_EQ(complete->header(), "$TMSCT");
+  EXPECT_EQ(complete->response_key(), "1");
+  EXPECT_FALSE(complete->has_script_exit());
+
+  auto const filled_in = raw_frame("TMSCT,1,ScriptExit()\r\n");
+  EXPECT_EQ(filled_in->to_str(), (TMSCT << ID{"1"} << ScriptExit())->to_str());
+  EXPECT_TRUE(filled_in->has_script_exit());
+
+  auto const status = raw_frame("TMSTA,00");
+  EXPECT_EQ(status->to_str(), "$TMSTA,2,00,*41\r\n");
+  EXPECT_EQ(status->response_key(), "00");
+
+  EXPECT_THROW(raw_frame("$TMSCT,8,1,Exit(),*76"), std::invalid_argument);  // checksum mismatch
+  EXPECT_THROW(raw_frame("$TMSCT,9,1,Exit(),*74"), std::invalid_argument);  // length mismatch
+  EXPECT_THROW(raw_frame("CPERR,04"), std::invalid_argument);
+  EXPECT_THROW(raw_frame("TMSCT"), std::invalid_argument);
+}
+
+TEST(TMMsgGen, PreparedScript) {
+  using namespace tm_robot_listener::motion_function;
+  using namespace std::string_literals;
+
+  auto const pose   = script_slot<std::array<float, 6>>(0);
+  auto const speed  = script_slot<int>(1);
+  auto const script = prepare(TMSCT << ID{"Servo"} << Line("CPP"s, pose, speed, 200, 0, false) << QueueTag(speed)
+                                    << End());
+  auto const expect = [](std::array<float, 6> const& t_pose, int t_speed) {
+    return (TMSCT << ID{"Servo"} << Line("CPP"s, t_pose, t_speed, 200, 0, false) << QueueTag(t_speed) << End())
+      ->to_str();
+  };
+
+  EXPECT_TRUE(script->empty());  // unbound slots are never sent
+  EXPECT_TRUE(script->to_str().empty());
+  EXPECT_EQ(script->response_key(), "Servo");
+
+  script->bind(pose, std::array<float, 6>{417, -122, 365, 180, 0, 90});
+  EXPECT_FALSE(script->ready());
+  script->bind(speed, 100);
+  ASSERT_TRUE(script->ready());
+  EXPECT_EQ(script->to_str(), expect({417, -122, 365, 180, 0, 90}, 100));
+
+  script->bind(speed, 5);  // slot used twice, length changes
+  EXPECT_EQ(script->to_str(), expect({417, -122, 365, 180, 0, 90}, 5));
+
+  script->bind(pose, std::array<float, 6>{1.5, 2, 3, -4, 5, 6});
+  EXPECT_EQ(script->to_str(), expect({1.5, 2, 3, -4, 5, 6}, 5));
+
+  std::string buffer{"$TMSTA,2,00,*41\r\n"};
+  script->serialize(buffer);
+  EXPECT_EQ(buffer, "$TMSTA,2,00,*41\r\n" + script->to_str());
+
+  EXPECT_THROW(script->bind(tm_robot_listener::Variable<int>{"speed"}, 1), std::invalid_argument);
+  EXPECT_THROW(script->bind(script_slot<int>(2), 1), std::invalid_argument);
+}
+
+TEST(TMMsgGen, ProductRecycled) {
+  using namespace tm_robot_listener::motion_function;
+
+  auto first            = TMSCT << ID{"1"} << QueueTag(1) << End();
+  auto const first_addr = first.get();
+  auto const second     = TMSCT << ID{"2"} << QueueTag(2) << End();
+  EXPECT_NE(second.get(), first_addr);  // still in use
+
+  first.reset();
+  auto builder     = TMSCT << ID{"3"};
+  auto const third = builder << QueueTag(3) << ScriptExit();
+  EXPECT_EQ(third.get(), first_addr);  // recycled
+  EXPECT_EQ(third->to_str(), "$TMSCT,27,3,QueueTag(3)\r\nScriptExit(),*53\r\n");
+
+  std::vector<BaseHeaderProductPtr> products;  // more than the pool holds
+  for (int i = 0; i < 64; ++i) {
+    products.push_back(TMSCT << ID{std::to_string(i)} << QueueTag(1) << End());
+  }
+  EXPECT_EQ(products.back()->to_str(), "$TMSCT,14,63,QueueTag(1),*6E\r\n");
+  EXPECT_EQ(third->to_str(), "$TMSCT,27,3,QueueTag(3)\r\nScriptExit(),*53\r\n");
+}
+
+TEST(TMMsgGen, NumberFormatting) {
+  using tm_robot_listener::value_to_string;
+
+  EXPECT_EQ(value_to_string<int>{}(-35), "-35");
+  EXPECT_EQ(value_to_string<int>{}(std::numeric_limits<int>::min()), "-2147483648");
+  EXPECT_EQ(value_to_string<std::uint64_t>{}(std::numeric_limits<std::uint64_t>::max()), "18446744073709551615");
+  EXPECT_EQ(value_to_string<float>{}(205), "205");
+  EXPECT_EQ(value_to_string<float>{}(-0.0F), "0");
+  EXPECT_EQ(value_to_string<float>{}(0.1F), "0.1");  // shortest round-trip, not 0.100000001
+  EXPECT_EQ(value_to_string<float>{}(1234567.5F), "1234567.5");
+  EXPECT_EQ(value_to_string<double>{}(10.1), "10.1");
+  EXPECT_EQ(value_to_string<double>{}(1.0 / 3), "0.3333333333333333");
+  EXPECT_EQ(std::stod(value_to_string<double>{}(0.1 + 0.2)), 0.1 + 0.2);
+  EXPECT_EQ(value_to_string<bool>{}(true), "true");
+  EXPECT_EQ((value_to_string<std::array<std::string, 2>>{}({"a", "b"})), R"({"a","b"})");
+  EXPECT_EQ((value_to_string<std::array<int, 0>>{}({})), "{}");
+
+  std::array<float, 6> const pose{417.1234F, -122.5F, 365, 180, -0.0001F, 90};
+  EXPECT_EQ((value_to_string<std::array<float, 6>>{}(pose)), "{417.1234,-122.5,365,180,-0.0001,90}");
+
+  tm_robot_listener::set_pose_precision(2);
+  EXPECT_EQ((value_to_string<std::array<float, 6>>{}(pose)), "{417.12,-122.5,365,180,0,90}");
+  EXPECT_EQ(value_to_string<float>{}(417.1234F), "417.1234");  // scalar values are not poses
+  tm_robot_listener::set_pose_precision(-1);
+  EXPECT_EQ((value_to_string<std::array<float, 6>>{}(pose)), "{417.1234,-122.5,365,180,-0.0001,90}");
 }
 
 int main(int argc, char** argv) {
@@ -1,5 +1,14 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#include "tm_robot_listener/detail/tmr_handler_index.hpp"
+#include "tm_robot_listener/detail/tmr_handler_slots.hpp"
+#include "tmr_listener_handle/tmr_async_listener_handle.hpp"
 #include "tmr_listener_handle/tmr_listener_handle.hpp"
 
 class MsgParseTester final : public tm_robot_listener::ListenerHandle {
@@ -7,14 +16,19 @@ class MsgParseTester final : public tm_robot_listener::ListenerHandle {
   tm_robot_listener::TMSCTResponse tmsct_resp_;
   tm_robot_listener::TMSTAResponse tmsta_resp_;
   tm_robot_listener::CPERRResponse cperr_resp_;
+  tm_robot_listener::motion_function::BaseHeaderProductPtr next_cmd_ =
+    tm_robot_listener::motion_function::empty_command_list();
+  MessageStatus last_status_ = MessageStatus::NotYetRespond;
+  tm_robot_listener::ConnectionState state_ = tm_robot_listener::ConnectionState::Disconnected;
 
  protected:
   tm_robot_listener::Decision start_task(std::vector<std::string> const& /*unused*/) override {
     return tm_robot_listener::Decision::Accept;
   }
 
-  tm_robot_listener::motion_function::BaseHeaderProductPtr generate_cmd(MessageStatus const /*unused*/) override {
-    return tm_robot_listener::motion_function::BaseHeaderProductPtr{};
+  tm_robot_listener::motion_function::BaseHeaderProductPtr generate_cmd(MessageStatus const t_status) override {
+    this->last_status_ = t_status;
+    return this->next_cmd_;
   }
 
   void response_msg(tm_robot_listener::TMSCTResponse const& t_resp) override { this->tmsct_resp_ = t_resp; }
@@ -23,59 +37,494 @@ class MsgParseTester final : public tm_robot_listener::ListenerHandle {
 
   void response_msg(tm_robot_listener::CPERRResponse const& t_resp) override { this->cperr_resp_ = t_resp; }
 
+  void connection_state_changed(tm_robot_listener::ConnectionState const t_state) noexcept override {
+    this->state_ = t_state;
+  }
+
   using tm_robot_listener::ListenerHandle::response_msg;
+
+ public:
+  using tm_robot_listener::ListenerHandle::set_response_timeout;
+};
+
+class NodeMessageTester final : public tm_robot_listener::ListenerHandle {
+ public:
+  std::vector<std::string> messages_;
+  int asked_ = 0;
+
+  explicit NodeMessageTester(std::vector<std::string> t_messages) : messages_{std::move(t_messages)} {}
+
+  std::vector<std::string> listen_node_messages() const override { return this->messages_; }
+
+ protected:
+  tm_robot_listener::Decision start_task(std::vector<std::string> const& t_data) override {
+    ++this->asked_;
+    auto const accepted = this->messages_.empty() or
+                          std::find(this->messages_.begin(), this->messages_.end(), t_data[0]) != this->messages_.end();
+    return accepted ? tm_robot_listener::Decision::Accept : tm_robot_listener::Decision::Ignore;
+  }
+
+  tm_robot_listener::motion_function::BaseHeaderProductPtr generate_cmd(MessageStatus /*unused*/) override {
+    return tm_robot_listener::motion_function::empty_command_list();
+  }
 };
 
+class AsyncTester final : public tm_robot_listener::AsyncListenerHandle {
+ public:
+  std::mutex mutex_;
+  std::condition_variable released_;
+  bool release_ = true;
+  int generated_ = 0;
+
+  void release() {
+    std::lock_guard<std::mutex> lock{this->mutex_};
+    this->release_ = true;
+    this->released_.notify_all();
+  }
+
+ protected:
+  tm_robot_listener::Decision start_task(std::vector<std::string> const& /*unused*/) override {
+    return tm_robot_listener::Decision::Accept;
+  }
+
+  tm_robot_listener::motion_function::BaseHeaderProductPtr generate_cmd_async(MessageStatus /*unused*/) override {
+    using namespace tm_robot_listener::motion_function;
+
+    std::unique_lock<std::mutex> lock{this->mutex_};
+    this->released_.wait(lock, [this]() { return this->release_; });
+    return TMSCT << ID{std::to_string(++this->generated_)} << QueueTag(1) << End();
+  }
+};
+
+TEST(FrameParseTest, FieldMatch) {
+  using tm_robot_listener::parse_frame;
+
+  {
+    auto const frame = parse_frame("$TMSTA,15,00,true,Listen1,*79\r\n");
+    EXPECT_TRUE(frame.valid());
+    EXPECT_EQ(frame.header_, "$TMSTA");
+    EXPECT_EQ(frame.length_, "15");
+    EXPECT_EQ(frame.payload_, "00,true,Listen1");
+    EXPECT_EQ(frame.checksum_, "79");
+  }
+
+  {
+    auto const frame = parse_frame("$TMSTA,9,00,false,,*37");
+    EXPECT_TRUE(frame.valid());
+    EXPECT_EQ(frame.payload_, "00,false,");
+    EXPECT_EQ(frame.checksum_, "37");
+  }
+
+  {
+    auto const frame = parse_frame("$TMSTA,8,90,1*2=2,*48\r\n");
+    EXPECT_TRUE(frame.valid());
+    EXPECT_EQ(frame.payload_, "90,1*2=2");
+  }
+
+  EXPECT_FALSE(parse_frame("").valid());
+  EXPECT_FALSE(parse_frame("\r\n").valid());
+  EXPECT_FALSE(parse_frame("TMSCT,4,2,OK,*5F\r\n").valid());
+  EXPECT_FALSE(parse_frame("$TMSCT\r\n").valid());
+  EXPECT_FALSE(parse_frame("$TMSCT,4\r\n").valid());
+  EXPECT_FALSE(parse_frame("$TMSCT,4,2,OK\r\n").valid());
+  EXPECT_FALSE(parse_frame("$TMSCT,4,2,OK*5F\r\n").valid());
+}
+
+TEST(FrameParseTest, Verification) {
+  using tm_robot_listener::FrameView;
+  using tm_robot_listener::parse_frame;
+
+  EXPECT_EQ(parse_frame("$TMSCT,4,2,OK,*5F\r\n").error_, FrameView::Error::None);
+  EXPECT_EQ(parse_frame("$TMSCT,4,2,OK,*5f\r\n").error_, FrameView::Error::None);
+  EXPECT_EQ(parse_frame("$TMSCT,4,2,OK,*5E\r\n").error_, FrameView::Error::BadChecksum);
+  EXPECT_EQ(parse_frame("$TMSCT,4,2,OK,*5\r\n").error_, FrameView::Error::BadChecksum);
+  EXPECT_EQ(parse_frame("$TMSCT,4,2,OK,*5G\r\n").error_, FrameView::Error::BadChecksum);
+  EXPECT_EQ(parse_frame("$TMSCT,5,2,OK,*5F\r\n").error_, FrameView::Error::BadLength);
+  EXPECT_EQ(parse_frame("$TMSCT,-4,2,OK,*5F\r\n").error_, FrameView::Error::BadLength);
+  EXPECT_EQ(parse_frame("$TMSCT,,2,OK,*5F\r\n").error_, FrameView::Error::BadLength);
+  EXPECT_EQ(parse_frame("$TMSCT,4,2,OK\r\n").error_, FrameView::Error::Malformed);
+}
+
+TEST(FrameParseTest, FieldTokenize) {
+  using tm_robot_listener::FieldTokenizer;
+
+  FieldTokenizer tokenizer{"OK;;2;3;", ';'};
+  std::vector<std::string> fields;
+  for (boost::string_ref field; tokenizer.next(field);) {
+    fields.emplace_back(field.to_string());
+  }
+
+  EXPECT_EQ(fields, (std::vector<std::string>{"OK", "2", "3"}));
+}
+
 TEST(MsgParseTest, ContentMatch) {
+  using tm_robot_listener::parse_frame;
   MsgParseTester test;
 
-  test.handle_response({"$TMSCT", "4", "2", "OK", "*5F"});
+  test.handle_response(parse_frame("$TMSCT,4,2,OK,*5F\r\n"));
   EXPECT_TRUE(test.tmsct_resp_.abnormal_line_.empty());
   EXPECT_EQ(test.tmsct_resp_.id_, "2");
   EXPECT_TRUE(test.tmsct_resp_.script_result_);
 
-  test.handle_response({"$TMSCT", "8", "2", "OK;2;3", "*52"});
+  test.handle_response(parse_frame("$TMSCT,8,2,OK;2;3,*52\r\n"));
   EXPECT_EQ(test.tmsct_resp_.abnormal_line_, (std::vector<int>{2, 3}));
   EXPECT_EQ(test.tmsct_resp_.id_, "2");
   EXPECT_TRUE(test.tmsct_resp_.script_result_);
 
-  test.handle_response({"$TMSCT", "13", "3", "ERROR;1;2;3", "*3F"});
+  test.handle_response(parse_frame("$TMSCT,13,3,ERROR;1;2;3,*3F\r\n"));
   EXPECT_EQ(test.tmsct_resp_.abnormal_line_, (std::vector<int>{1, 2, 3}));
   EXPECT_EQ(test.tmsct_resp_.id_, "3");
   EXPECT_FALSE(test.tmsct_resp_.script_result_);
 
-  test.handle_response({"$TMSTA", "9", "00", "false", "*37"});
+  test.handle_response(parse_frame("$TMSTA,9,00,false,,*37\r\n"));
   EXPECT_EQ(test.tmsta_resp_.subcmd_, 0);
   EXPECT_EQ(test.tmsta_resp_.data_, (std::vector<std::string>{"false"}));
 
-  test.handle_response({"$TMSTA", "15", "00", "true", "Listen1", "*79"});
+  test.handle_response(parse_frame("$TMSTA,15,00,true,Listen1,*79\r\n"));
   EXPECT_EQ(test.tmsta_resp_.subcmd_, 0);
   EXPECT_EQ(test.tmsta_resp_.data_, (std::vector<std::string>{"true", "Listen1"}));
 
-  test.handle_response({"$TMSTA", "10", "01", "08", "true", "*6D"});
+  test.handle_response(parse_frame("$TMSTA,10,01,08,true,*6D\r\n"));
   EXPECT_EQ(test.tmsta_resp_.subcmd_, 1);
   EXPECT_EQ(test.tmsta_resp_.data_, (std::vector<std::string>{"08", "true"}));
 
-  test.handle_response({"$TMSTA", "14", "90", "Hello World", "*73"});
+  test.handle_response(parse_frame("$TMSTA,14,90,Hello World,*73\r\n"));
   EXPECT_EQ(test.tmsta_resp_.subcmd_, 90);
   EXPECT_EQ(test.tmsta_resp_.data_, (std::vector<std::string>{"Hello World"}));
 
-  test.handle_response({"$CPERR", "2", "01", "*49"});
+  test.handle_response(parse_frame("$CPERR,2,01,*49\r\n"));
   EXPECT_EQ(test.cperr_resp_.err_, tm_robot_listener::ErrorCode::BadArgument);
 
-  test.handle_response({"$CPERR", "2", "02", "*4A"});
+  test.handle_response(parse_frame("$CPERR,2,02,*4A\r\n"));
   EXPECT_EQ(test.cperr_resp_.err_, tm_robot_listener::ErrorCode::BadCheckSum);
 
-  test.handle_response({"$CPERR", "2", "03", "*4B"});
+  test.handle_response(parse_frame("$CPERR,2,03,*4B\r\n"));
   EXPECT_EQ(test.cperr_resp_.err_, tm_robot_listener::ErrorCode::BadHeader);
 
-  test.handle_response({"$CPERR", "2", "04", "*4C"});
+  test.handle_response(parse_frame("$CPERR,2,04,*4C\r\n"));
   EXPECT_EQ(test.cperr_resp_.err_, tm_robot_listener::ErrorCode::InvalidData);
 
-  test.handle_response({"$CPERR", "2", "F1", "*3F"});
+  test.handle_response(parse_frame("$CPERR,2,F1,*3F\r\n"));
   EXPECT_EQ(test.cperr_resp_.err_, tm_robot_listener::ErrorCode::NotInListenNode);
 }
 
+TEST(MsgParseTest, IllFormedData) {
+  using tm_robot_listener::parse_frame;
+  MsgParseTester test;
+
+  EXPECT_TRUE(test.handle_response(parse_frame("$TMSTA,5,01,88,*6B\r\n")));
+  EXPECT_FALSE(test.handle_response(parse_frame("$TMSTA,4,XXXX,*47\r\n")));
+  EXPECT_FALSE(test.handle_response(parse_frame("$TMSCT,8,2,OK;x;3,*18\r\n")));
+  EXPECT_FALSE(test.handle_response(parse_frame("$CPERR,2,ZZ,*48\r\n")));
+  EXPECT_FALSE(test.handle_response(parse_frame("$TMsct,4,2,OK,*7F\r\n")));
+}
+
+TEST(MsgParseTest, ParseWithoutHandler) {
+  using tm_robot_listener::parse_frame;
+  using tm_robot_listener::parse_response;
+
+  tm_robot_listener::TMSTAResponse tmsta;
+  EXPECT_TRUE(parse_response(parse_frame("$TMSTA,14,90,Hello World,*73\r\n"), tmsta));
+  EXPECT_EQ(tmsta.subcmd_, 90);
+  EXPECT_EQ(tmsta.data_, (std::vector<std::string>{"Hello World"}));
+
+  tm_robot_listener::TMSCTResponse tmsct;
+  EXPECT_FALSE(parse_response(parse_frame("$TMSTA,14,90,Hello World,*73\r\n"), tmsct));  // header mismatch
+  EXPECT_TRUE(parse_response(parse_frame("$TMSCT,13,3,ERROR;1;2;3,*3F\r\n"), tmsct));
+  EXPECT_EQ(tmsct.abnormal_line_, (std::vector<int>{1, 2, 3}));
+
+  tm_robot_listener::CPERRResponse cperr;
+  EXPECT_TRUE(parse_response(parse_frame("$CPERR,2,F1,*3F\r\n"), cperr));
+  EXPECT_EQ(cperr.err_, tm_robot_listener::ErrorCode::NotInListenNode);
+  EXPECT_FALSE(parse_response(parse_frame("$CPERR,2,ZZ,*48\r\n"), cperr));
+}
+
+TEST(MsgParseTest, ResponseCorrelation) {
+  using namespace tm_robot_listener::motion_function;
+  using tm_robot_listener::parse_frame;
+  MsgParseTester test;
+
+  test.generate_request();
+  EXPECT_EQ(test.last_status_, MsgParseTester::MessageStatus::Responded);
+  EXPECT_EQ(test.in_flight_count(), 0U);
+  EXPECT_EQ(test.oldest_in_flight(), std::chrono::steady_clock::time_point::max());
+
+  auto const first_generated_at = std::chrono::steady_clock::now();
+  test.next_cmd_                = TMSCT << ID{"1"} << QueueTag(1) << End();
+  test.generate_request();
+  EXPECT_GE(test.oldest_in_flight(), first_generated_at);
+  EXPECT_LE(test.oldest_in_flight(), std::chrono::steady_clock::now());
+  test.next_cmd_ = TMSCT << ID{"2"} << QueueTag(2) << End();
+  test.generate_request();
+  test.next_cmd_ = TMSTA << QueueTagDone(1) << End();
+  test.generate_request();
+  EXPECT_EQ(test.last_status_, MsgParseTester::MessageStatus::NotYetRespond);
+  EXPECT_EQ(test.in_flight_count(), 3U);
+
+  // responses arrive out of order, each one is matched to its own request
+  test.handle_response(parse_frame("$TMSCT,4,2,OK,*5F\r\n"));
+  EXPECT_EQ(test.tmsct_resp_.id_, "2");
+  EXPECT_EQ(test.in_flight_count(), 2U);
+  EXPECT_EQ(test.last_round_trip(), test.tmsct_resp_.round_trip_);
+
+  test.handle_response(parse_frame("$TMSCT,4,3,OK,*5E\r\n"));  // unknown ID, nothing is taken
+  EXPECT_EQ(test.in_flight_count(), 2U);
+  EXPECT_EQ(test.last_round_trip(), std::chrono::steady_clock::duration::zero());
+
+  test.handle_response(parse_frame("$TMSTA,10,01,01,none,*78\r\n"));
+  EXPECT_EQ(test.in_flight_count(), 1U);
+
+  test.next_cmd_ = empty_command_list();
+  test.generate_request();
+  EXPECT_EQ(test.last_status_, MsgParseTester::MessageStatus::NotYetRespond);
+
+  test.handle_response(parse_frame("$CPERR,2,04,*4C\r\n"));  // CPERR answers the oldest request
+  EXPECT_EQ(test.in_flight_count(), 0U);
+
+  test.generate_request();
+  EXPECT_EQ(test.last_status_, MsgParseTester::MessageStatus::Responded);
+}
+
+TEST(MsgParseTest, ResponseTimeout) {
+  using namespace tm_robot_listener::motion_function;
+  MsgParseTester test;
+  test.set_response_timeout(std::chrono::milliseconds{20});
+
+  test.next_cmd_ = TMSCT << ID{"1"} << QueueTag(1) << End();
+  test.generate_request();
+  std::this_thread::sleep_for(std::chrono::milliseconds{30});
+  test.next_cmd_ = TMSTA << QueueTagDone(1) << End();
+  test.generate_request();  // the TMSCT request expires before it is asked
+  EXPECT_EQ(test.last_status_, MsgParseTester::MessageStatus::Responded);
+  EXPECT_EQ(test.in_flight_count(), 1U);
+
+  test.next_cmd_ = empty_command_list();
+  test.generate_request();  // the TMSTA request is still waiting
+  EXPECT_EQ(test.last_status_, MsgParseTester::MessageStatus::NotYetRespond);
+
+  test.set_response_timeout(std::chrono::steady_clock::duration::zero());  // never expires
+  std::this_thread::sleep_for(std::chrono::milliseconds{30});
+  test.generate_request();
+  EXPECT_EQ(test.in_flight_count(), 1U);
+}
+
+TEST(MsgParseTest, ConnectionState) {
+  using namespace tm_robot_listener::motion_function;
+  using tm_robot_listener::ConnectionState;
+  MsgParseTester test;
+
+  test.handle_connection_state(ConnectionState::InListenNode);
+  EXPECT_EQ(test.state_, ConnectionState::InListenNode);
+
+  test.next_cmd_ = TMSCT << ID{"1"} << QueueTag(1) << End();
+  test.generate_request();
+  EXPECT_EQ(test.in_flight_count(), 1U);
+
+  test.handle_connection_state(ConnectionState::Connected);  // left listen node, the response may still come
+  EXPECT_EQ(test.in_flight_count(), 1U);
+
+  test.handle_connection_state(ConnectionState::Disconnected);  // never responded once disconnected
+  EXPECT_EQ(test.state_, ConnectionState::Disconnected);
+  EXPECT_EQ(test.in_flight_count(), 0U);
+}
+
+TEST(MsgParseTest, AsyncGeneration) {
+  using tm_robot_listener::HandlerContext;
+
+  {  // not attached, generated in place
+    AsyncTester test;
+    EXPECT_EQ(test.generate_request()->response_key(), "1");
+    EXPECT_FALSE(test.generating());
+  }
+
+  AsyncTester test;
+  std::vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable woken;
+  int wake_up_count = 0;
+
+  auto wake_up = [&]() {
+    std::lock_guard<std::mutex> lock{mutex};
+    ++wake_up_count;
+    woken.notify_all();
+  };
+  auto post_work = [&workers](std::function<void()> t_job) { workers.emplace_back(std::move(t_job)); };
+  auto wait_for_wake_up = [&](int const t_count) {
+    std::unique_lock<std::mutex> lock{mutex};
+    return woken.wait_for(lock, std::chrono::seconds{5}, [&]() { return wake_up_count >= t_count; });
+  };
+
+  test.attach(HandlerContext{wake_up, post_work});
+  test.release_ = false;
+
+  EXPECT_TRUE(test.generate_request()->empty());  // posted to the worker, the I/O thread is not blocked
+  EXPECT_TRUE(test.generating());
+  EXPECT_TRUE(test.generate_request()->empty());
+  EXPECT_EQ(workers.size(), 1U);  // only one command is generated at a time
+
+  test.release();
+  ASSERT_TRUE(wait_for_wake_up(1));
+  EXPECT_FALSE(test.generating());
+  EXPECT_EQ(test.generate_request()->response_key(), "1");
+  EXPECT_EQ(test.in_flight_count(), 1U);
+
+  // command generated for a previous task is dropped
+  EXPECT_TRUE(test.generate_request()->empty());
+  ASSERT_TRUE(wait_for_wake_up(2));
+  test.start_task_handling({});
+  EXPECT_EQ(test.in_flight_count(), 0U);
+  EXPECT_TRUE(test.generate_request()->empty());
+  ASSERT_TRUE(wait_for_wake_up(3));
+  EXPECT_EQ(test.generate_request()->response_key(), "3");
+
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
+TEST(MsgParseTest, AsyncStaleCommand) {
+  using tm_robot_listener::HandlerContext;
+
+  AsyncTester test;
+  std::vector<std::function<void()>> jobs;  // run by hand, so that the task can start at any point
+  test.attach(HandlerContext{[]() {}, [&jobs](std::function<void()> t_job) { jobs.push_back(std::move(t_job)); }});
+
+  EXPECT_TRUE(test.generate_request()->empty());
+  ASSERT_EQ(jobs.size(), 1U);
+
+  test.start_task_handling({});  // the task starts while the command is being generated
+  jobs[0]();                      // the worker publishes the command of the previous task
+  EXPECT_FALSE(test.generating());
+
+  EXPECT_TRUE(test.generate_request()->empty());  // dropped, generated again for the current task
+  ASSERT_EQ(jobs.size(), 2U);
+  jobs[1]();
+  EXPECT_EQ(test.generate_request()->response_key(), "2");
+}
+
+TEST(MsgParseTest, HandlerIndex) {
+  using tm_robot_listener::detail::HandlerIndex;
+
+  std::vector<std::shared_ptr<NodeMessageTester>> const handlers{
+    std::make_shared<NodeMessageTester>(std::vector<std::string>{"VisionFail", "UltrasonicFail"}),
+    std::make_shared<NodeMessageTester>(std::vector<std::string>{"Pick"}),
+    std::make_shared<NodeMessageTester>(std::vector<std::string>{}),  // accepts everything, probed for every message
+    std::make_shared<NodeMessageTester>(std::vector<std::string>{"Pick", "Pick", "Place"})};
+
+  HandlerIndex const index{handlers};
+  EXPECT_EQ(index.dynamic_count(), 1U);
+
+  auto const find = [&](std::string const& t_message) {
+    return index.find(t_message, [&](std::size_t const t_index) {
+      return handlers[t_index]->start_task_handling({t_message}) == tm_robot_listener::Decision::Accept;
+    });
+  };
+
+  EXPECT_EQ(find("UltrasonicFail"), 0U);
+  EXPECT_EQ(find("Pick"), 1U);
+  EXPECT_EQ(find("Place"), 2U);  // load order is kept, the dynamic handler comes first
+  EXPECT_EQ(find("Unknown"), 2U);
+  EXPECT_EQ(handlers[0]->asked_, 1);
+  EXPECT_EQ(handlers[1]->asked_, 1);
+  EXPECT_EQ(handlers[3]->asked_, 0);
+
+  handlers[2]->messages_ = {"Other"};  // not indexed again, still asked for every message, but now ignores "Place"
+  EXPECT_EQ(find("Place"), 3U);
+  EXPECT_EQ(find("Unknown"), std::size_t{HandlerIndex::NOT_FOUND});
+  EXPECT_EQ(HandlerIndex{}.find("Pick", [](std::size_t) { return true; }), std::size_t{HandlerIndex::NOT_FOUND});
+}
+
+TEST(MsgParseTest, LazyHandleParse) {
+  using tm_robot_listener::detail::LazyMessages;
+  using tm_robot_listener::detail::parse_lazy_handles;
+  using XmlRpc::XmlRpcValue;
+
+  auto const entry = [](char const* t_name, std::vector<XmlRpcValue> const& t_messages) {
+    XmlRpcValue ret_val;
+    if (t_name != nullptr) {
+      ret_val["name"] = t_name;
+    }
+
+    ret_val["messages"].setSize(static_cast<int>(t_messages.size()));
+    for (std::size_t i = 0; i < t_messages.size(); ++i) {
+      ret_val["messages"][static_cast<int>(i)] = t_messages[i];
+    }
+
+    return ret_val;
+  };
+
+  XmlRpcValue param;
+  param.setSize(6);
+  param[0] = entry("tm_error_handler::TMErrorHandler", {"VisionFail", "UltrasonicFail"});
+  param[1] = "tm_error_handler::TMErrorHandler";            // not a struct
+  param[2] = entry(nullptr, {"Pick"});                      // no name
+  param[3] = entry("tm_pick::TMPickHandler", {});           // no message
+  param[4] = entry("tm_pick::TMPickHandler", {"Pick", 1});  // a message that is not a string
+  param[5] = entry("tm_place::TMPlaceHandler", {"Place"});
+
+  LazyMessages messages;
+  std::vector<int> malformed;
+  ASSERT_TRUE(parse_lazy_handles(param, messages, malformed));
+  EXPECT_EQ(messages, (LazyMessages{{"tm_error_handler::TMErrorHandler", {"VisionFail", "UltrasonicFail"}},
+                                    {"tm_place::TMPlaceHandler", {"Place"}}}));
+  EXPECT_EQ(malformed, (std::vector<int>{1, 2, 3, 4}));
+
+  XmlRpcValue not_list{"tm_place::TMPlaceHandler"};
+  messages.clear();
+  malformed.clear();
+  EXPECT_FALSE(parse_lazy_handles(not_list, messages, malformed));
+  EXPECT_TRUE(messages.empty());
+  EXPECT_TRUE(malformed.empty());
+}
+
+TEST(MsgParseTest, LazyHandlerCreation) {
+  using Handler = std::shared_ptr<NodeMessageTester>;
+
+  std::map<std::string, std::vector<std::string>> const plugins{
+    {"error", {"VisionFail", "UltrasonicFail"}}, {"pick", {"Pick"}}, {"place", {"Place"}}, {"any", {}}};
+  std::vector<std::string> created;
+  auto const create = [&](std::string const& t_name) {
+    created.push_back(t_name);
+    auto const plugin = plugins.find(t_name);
+    return plugin == plugins.end() ? nullptr : std::make_shared<NodeMessageTester>(plugin->second);
+  };
+
+  tm_robot_listener::detail::HandlerSlots<Handler> slots;
+  auto const loaded = slots.load({"error", "broken", "pick", "lazy_broken", "place", "any"},
+                                 {{"error", {"VisionFail", "UltrasonicFail"}}, {"lazy_broken", {"Pick"}}}, create);
+  EXPECT_EQ(loaded, 3U);
+  EXPECT_EQ(slots.size(), 6U);
+  EXPECT_EQ(slots.deferred_count(), 2U);
+  EXPECT_EQ(created, (std::vector<std::string>{"broken", "pick", "place", "any"}));
+  EXPECT_FALSE(slots[0].handler_);
+  EXPECT_TRUE(slots[1].failed_);
+
+  auto const find = [&](std::string const& t_message) {
+    return slots.find(t_message, create, [&](Handler const& t_handler) {
+      return t_handler->start_task_handling({t_message}) == tm_robot_listener::Decision::Accept;
+    });
+  };
+
+  EXPECT_EQ(find("Place"), 4U);  // no lazy handler is created for a message it doesn't declare
+  EXPECT_EQ(slots.deferred_count(), 2U);
+
+  EXPECT_EQ(find("UltrasonicFail"), 0U);  // created the first time one of its messages is seen
+  EXPECT_EQ(find("VisionFail"), 0U);      // and only once
+  ASSERT_TRUE(slots[0].handler_);
+  EXPECT_EQ(slots[0].handler_->asked_, 2);
+  EXPECT_EQ(slots.deferred_count(), 1U);
+
+  EXPECT_EQ(find("Pick"), 2U);  // the lazy handler after pick is not created as long as pick accepts
+  EXPECT_EQ(slots.deferred_count(), 1U);
+
+  slots[2].handler_->messages_ = {"Other"};
+  EXPECT_EQ(find("Pick"), 5U);  // lazy_broken fails to be created, and is skipped
+  EXPECT_EQ(find("Pick"), 5U);  // without being tried again
+  EXPECT_TRUE(slots[3].failed_);
+  EXPECT_EQ(slots.deferred_count(), 0U);
+  EXPECT_EQ(created, (std::vector<std::string>{"broken", "pick", "place", "any", "error", "lazy_broken"}));
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
 
@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+
+#include "tmr_listener_handle/tmr_pvt_stream.hpp"
+
+namespace {
+
+tm_robot_listener::PVTStream::Options test_options() {
+  tm_robot_listener::PVTStream::Options options;
+  options.frame_budget_  = 100;
+  options.look_ahead_    = 2;
+  options.poll_interval_ = std::chrono::steady_clock::duration::zero();
+  return options;
+}
+
+tm_robot_listener::PVTSample sample(float const t_x) {
+  return tm_robot_listener::PVTSample{{t_x, 0, 0, 0, 0, 0}, {1, 0, 0, 0, 0, 0}, 0.5F};
+}
+
+tm_robot_listener::TMSTAResponse tag_done(int const t_tag, bool const t_done) {
+  return tm_robot_listener::TMSTAResponse{1, {std::to_string(t_tag), t_done ? "true" : "false"}};
+}
+
+std::size_t count(std::string const& t_str, std::string const& t_token) {
+  std::size_t ret_val = 0;
+  for (auto pos = t_str.find(t_token); pos != std::string::npos; pos = t_str.find(t_token, pos + 1)) {
+    ++ret_val;
+  }
+  return ret_val;
+}
+
+}  // namespace
+
+TEST(PVTStreamTest, BatchAndFlowControl) {
+  using tm_robot_listener::PVTStream;
+
+  PVTStream stream{test_options()};
+  EXPECT_TRUE(stream.next_command()->empty());  // nothing pushed yet
+  EXPECT_EQ(stream.state(), PVTStream::State::Idle);
+
+  for (int i = 0; i < 6; ++i) {
+    ASSERT_TRUE(stream.push(sample(static_cast<float>(i))));
+  }
+
+  auto const first = stream.next_command()->to_str();
+  EXPECT_EQ(first.find("$TMSCT,"), 0U);
+  EXPECT_NE(first.find("PVTStream,PVTEnter(0)\r\nPVTPoint({0,0,0,0,0,0},{1,0,0,0,0,0},0.5)"), std::string::npos);
+  EXPECT_NE(first.find("QueueTag(1)"), std::string::npos);
+  EXPECT_EQ(stream.state(), PVTStream::State::Streaming);
+
+  auto const second = stream.next_command()->to_str();
+  EXPECT_EQ(count(second, "PVTEnter"), 0U);
+  EXPECT_NE(second.find("QueueTag(2)"), std::string::npos);
+  EXPECT_EQ(count(first, "PVTPoint") + count(second, "PVTPoint") + stream.buffered_points(), 6U);
+  EXPECT_GT(stream.buffered_points(), 0U);
+
+  // look-ahead is full, the oldest tag is polled once
+  EXPECT_EQ(stream.next_command()->to_str(), "$TMSTA,4,01,1,*5B\r\n");
+  EXPECT_TRUE(stream.next_command()->empty());
+
+  stream.handle_response(tag_done(1, false));
+  EXPECT_EQ(stream.queued_frames(), 2U);
+  EXPECT_EQ(stream.next_command()->to_str(), "$TMSTA,4,01,1,*5B\r\n");
+  stream.handle_response(tag_done(1, true));
+  EXPECT_EQ(stream.queued_frames(), 1U);
+
+  stream.finish();
+  EXPECT_FALSE(stream.push(sample(7)));
+  while (stream.buffered_points() != 0) {
+    auto const command = stream.next_command();
+    ASSERT_FALSE(command->empty());
+    if (command->header() == "$TMSTA") {
+      stream.handle_response(tag_done(std::stoi(command->to_str().substr(12)), true));
+    }
+  }
+
+  // every frame must be done before exiting PVT mode
+  while (stream.queued_frames() != 0) {
+    auto const command = stream.next_command();
+    ASSERT_EQ(command->header(), "$TMSTA");
+    stream.handle_response(tag_done(std::stoi(command->to_str().substr(12)), true));
+  }
+
+  EXPECT_EQ(stream.next_command()->to_str(), "$TMSCT,17,PVTExit,PVTExit(),*5A\r\n");
+  EXPECT_EQ(stream.state(), PVTStream::State::Exiting);
+  EXPECT_TRUE(stream.next_command()->empty());
+
+  stream.handle_response(tm_robot_listener::TMSCTResponse{"PVTExit", true});
+  EXPECT_EQ(stream.state(), PVTStream::State::Done);
+}
+
+TEST(PVTStreamTest, FailureAndReset) {
+  using tm_robot_listener::PVTStream;
+
+  PVTStream stream{test_options()};
+  stream.push(sample(0));
+  EXPECT_FALSE(stream.next_command()->empty());
+
+  stream.handle_response(tm_robot_listener::TMSCTResponse{"Other", false});  // not ours
+  EXPECT_EQ(stream.state(), PVTStream::State::Streaming);
+
+  stream.handle_response(tm_robot_listener::TMSCTResponse{"PVTStream", false, {2}});
+  EXPECT_EQ(stream.state(), PVTStream::State::Failed);
+  EXPECT_TRUE(stream.next_command()->empty());
+
+  stream.reset();
+  EXPECT_EQ(stream.state(), PVTStream::State::Idle);
+  EXPECT_EQ(stream.queued_frames(), 0U);
+
+  stream.finish();
+  EXPECT_TRUE(stream.next_command()->empty());  // finished without any point, PVT mode is never entered
+  EXPECT_EQ(stream.state(), PVTStream::State::Done);
+}
+
+TEST(PVTStreamTest, TagsWrapAround) {
+  using tm_robot_listener::PVTStream;
+
+  auto options          = test_options();
+  options.frame_budget_ = 1;  // one point per frame
+  options.look_ahead_   = 100;
+  PVTStream stream{options};
+
+  for (int i = 0; i < PVTStream::MAX_QUEUE_TAG + 1; ++i) {
+    stream.push(sample(static_cast<float>(i)));
+  }
+
+  for (int tag = 1; tag <= PVTStream::MAX_QUEUE_TAG; ++tag) {
+    auto const frame = stream.next_command()->to_str();
+    EXPECT_NE(frame.find("QueueTag(" + std::to_string(tag) + ')'), std::string::npos) << frame;
+  }
+
+  // look-ahead is clamped to the number of distinct tags
+  EXPECT_EQ(stream.next_command()->header(), "$TMSTA");
+  stream.handle_response(tag_done(1, true));
+  EXPECT_NE(stream.next_command()->to_str().find("QueueTag(1)"), std::string::npos);
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
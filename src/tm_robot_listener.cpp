@@ -1,44 +1,150 @@
 #include <boost/asio/buffer.hpp>
 #include <boost/asio/placeholders.hpp>
-#include <boost/asio/steady_timer.hpp>
-#include <boost/tokenizer.hpp>
 
+#include <algorithm>
 #include <chrono>
 #include <functional>
+#include <future>
+#include <iomanip>
 #include <numeric>
+#include <sstream>
 
 #include "tm_robot_listener/tm_robot_listener.hpp"
 
-namespace {
+namespace tm_robot_listener {
 
-inline auto get_tokenized_result(std::string const &t_result) noexcept {
-  auto const tok_res = boost::tokenizer<boost::char_separator<char>>(t_result, boost::char_separator<char>(","));
-  auto const ret_val = std::vector<std::string>{tok_res.begin(), tok_res.end()};
-  return ret_val;
+constexpr std::array<char const *, 4> TMRobotListener::LATENCY_HEADERS;
+constexpr std::array<char const *, static_cast<std::size_t>(TMRobotListener::LatencyStage::Count)>
+  TMRobotListener::LATENCY_STAGES;
+
+/**
+ * @details Invalid parameters are corrected rather than refused, see detail::Backoff.
+ */
+void TMRobotListener::configure_connection() noexcept {
+  using std::chrono::duration_cast;
+  auto const param_double = [this](std::string const &t_name, double const t_default) {
+    return this->private_nh_.param(t_name, t_default);
+  };
+  auto const param_duration = [&param_double](std::string const &t_name, double const t_default) {
+    std::chrono::duration<double> const seconds{std::max(0.0, param_double(t_name, t_default))};
+    return duration_cast<Clock::duration>(seconds);
+  };
+
+  this->reconnect_backoff_ = detail::Backoff{param_duration("reconnect_min_delay", DEFAULT_RECONNECT_MIN_DELAY),
+                                             param_duration("reconnect_max_delay", DEFAULT_RECONNECT_MAX_DELAY),
+                                             param_double("reconnect_factor", DEFAULT_RECONNECT_FACTOR),
+                                             param_double("reconnect_jitter", DEFAULT_RECONNECT_JITTER)};
+  this->connect_timeout_   = std::max<Clock::duration>(param_duration("connect_timeout", DEFAULT_CONNECT_TIMEOUT),
+                                                       std::chrono::milliseconds{1});
+
+  this->keep_alive_.enabled_  = this->private_nh_.param("tcp_keepalive", this->keep_alive_.enabled_);
+  this->keep_alive_.idle_     = std::max(1, this->private_nh_.param("tcp_keepalive_idle", this->keep_alive_.idle_));
+  this->keep_alive_.interval_ =
+    std::max(1, this->private_nh_.param("tcp_keepalive_interval", this->keep_alive_.interval_));
+  this->keep_alive_.count_ = std::max(1, this->private_nh_.param("tcp_keepalive_count", this->keep_alive_.count_));
 }
 
-inline auto strip_crlf(std::string const &t_input) noexcept {
-  return t_input.size() < 2 ? t_input : std::string{t_input.begin(), t_input.end() - 2};
+/**
+ * @details The attempt is abandoned by closing the socket, handle_connection then sees operation_aborted, and
+ *          retries as for any other failure. The timer is cancelled by handle_connection, if the attempt completes
+ *          first.
+ */
+void TMRobotListener::connect() noexcept {
+  using namespace boost::asio::placeholders;
+
+  this->set_connection_state(ConnectionState::Connecting);
+  this->listener_.async_connect(this->tm_robot_,
+                                this->strand_.wrap(boost::bind(&TMRobotListener::handle_connection, this, error)));
+
+  this->connect_timer_.expires_from_now(this->connect_timeout_);
+  this->connect_timer_.async_wait(this->strand_.wrap([this](boost::system::error_code const &t_err) {
+    if (not t_err and not this->stopping_ and this->connection_state_ == ConnectionState::Connecting) {
+      ROS_WARN_STREAM_THROTTLE_NAMED(1.0, "tm_socket_connection", "Connection timed out");
+
+      boost::system::error_code ignore_error_code;
+      this->listener_.close(ignore_error_code);
+    }
+  }));
 }
 
-}  // namespace
+/**
+ * @details The delay grows on every failed attempt, and is reset once connected, a robot powered off is therefore
+ *          tried at most once every reconnect_max_delay seconds, while a dropped connection is retried soon.
+ */
+void TMRobotListener::schedule_reconnect() noexcept {
+  boost::system::error_code ignore_error_code;
+  this->listener_.close(ignore_error_code);
+  this->set_connection_state(ConnectionState::Disconnected);
 
-namespace tm_robot_listener {
+  auto const delay = this->reconnect_backoff_.next_delay(this->jitter_rng_);
+  ROS_DEBUG_STREAM_NAMED("tm_socket_connection",
+                         "Reconnecting in " << std::chrono::duration<double>{delay}.count() << " s");
 
-void TMRobotListener::check_ros_heartbeat(boost::system::error_code const &t_err) noexcept {
-  using namespace boost::asio::placeholders;
+  this->reconnect_timer_.expires_from_now(delay);
+  this->reconnect_timer_.async_wait(this->strand_.wrap([this](boost::system::error_code const &t_err) {
+    if (not t_err and not this->stopping_) {
+      this->connect();
+    }
+  }));
+}
 
-  if (not ros::ok() or t_err) {  // NOLINT boost pre c++11 safe bool idiom
-    ROS_ERROR_STREAM_COND_NAMED(ros::ok(), "tm_socket_ros_heartbeat_timer", "Timer Error: " << t_err.message());
-    this->stop();
-  } else {
-    this->ros_heartbeat_timer_.expires_from_now(HEARTBEAT_INTERVAL());
-    this->ros_heartbeat_timer_.async_wait(boost::bind(&TMRobotListener::check_ros_heartbeat, this, error));
+/**
+ * @details The probe timing is only tuned where the platform supports it, otherwise the system defaults apply, which
+ *          are usually hours on Linux. Failing to set the options is not fatal, the connection goes on without them.
+ */
+void TMRobotListener::set_keep_alive() noexcept {
+  boost::system::error_code err;
+  this->listener_.set_option(boost::asio::socket_base::keep_alive{this->keep_alive_.enabled_}, err);
+
+#if defined(TCP_KEEPIDLE) && defined(TCP_KEEPINTVL) && defined(TCP_KEEPCNT)
+  using boost::asio::detail::socket_option::integer;
+  if (not err and this->keep_alive_.enabled_) {
+    this->listener_.set_option(integer<IPPROTO_TCP, TCP_KEEPIDLE>{this->keep_alive_.idle_}, err);
+  }
+
+  if (not err and this->keep_alive_.enabled_) {
+    this->listener_.set_option(integer<IPPROTO_TCP, TCP_KEEPINTVL>{this->keep_alive_.interval_}, err);
+  }
+
+  if (not err and this->keep_alive_.enabled_) {
+    this->listener_.set_option(integer<IPPROTO_TCP, TCP_KEEPCNT>{this->keep_alive_.count_}, err);
+  }
+#endif
+
+  if (err) {
+    ROS_WARN_STREAM_NAMED("tm_socket_connection", "Failed to set TCP keepalive, reason: " << err.message());
+  }
+}
+
+/**
+ * @details Handlers are told on the I/O thread, in the order they are loaded. Lazy handlers not yet created are
+ *          skipped, so is default_task_handler_.
+ */
+void TMRobotListener::set_connection_state(ConnectionState const t_state) noexcept {
+  if (this->connection_state_.exchange(t_state) == t_state) {
+    return;
   }
+
+  ROS_DEBUG_STREAM_NAMED("tm_socket_connection", "Connection state: " << to_string(t_state));
+  for (auto &slot : this->task_handlers_) {
+    if (slot.handler_) {
+      slot.handler_->handle_connection_state(t_state);
+    }
+  }
+}
+
+/**
+ * @details TM robot leaves the listen node once ScriptExit() is sent, the connection stays.
+ */
+void TMRobotListener::end_task() noexcept {
+  this->current_task_handler_.reset();
+  this->current_handler_index_ = NO_HANDLER;
+  this->set_connection_state(ConnectionState::Connected);
 }
 
 /**
- * @details This handler always tries to reconnect to the server, unless ROS is stopped.
+ * @details A failed attempt is retried after the backoff delay, unless the listener is stopped, see
+ *          schedule_reconnect.
  *
  *           After the connection is established, obtain first message when entering listener node, this message serves
  *           as a signal to tell which handler should handle the work
@@ -46,34 +152,38 @@ void TMRobotListener::check_ros_heartbeat(boost::system::error_code const &t_err
 void TMRobotListener::handle_connection(boost::system::error_code const &t_err) noexcept {
   using namespace boost::asio::placeholders;
 
-  if (not ros::ok()) {
+  if (this->stopping_) {
     return;
   }
 
+  boost::system::error_code ignore_error_code;
+  this->connect_timer_.cancel(ignore_error_code);
+
   if (t_err) {
     ROS_ERROR_STREAM_THROTTLE_NAMED(1.0, "tm_socket_connection",
                                     "Connection error, reason: " << t_err.message() << ", retrying...");
 
-    this->listener_.async_connect(this->tm_robot_, boost::bind(&TMRobotListener::handle_connection, this, error));
+    this->schedule_reconnect();
   } else {
     ROS_INFO_STREAM_NAMED("tm_socket_connection", "Connection success, waiting for server response");
+    this->reconnect_backoff_.reset();
+    this->set_keep_alive();
+    this->set_connection_state(ConnectionState::Connected);
 
-    boost::asio::async_read_until(this->listener_, this->input_buffer_, MESSAGE_END_BYTE,
-                                  boost::bind(&TMRobotListener::handle_read, this, error, bytes_transferred));
+    boost::asio::async_read_until(
+      this->listener_, this->input_buffer_, MESSAGE_END_BYTE,
+      this->strand_.wrap(boost::bind(&TMRobotListener::handle_read, this, error, bytes_transferred)));
   }
 }
 
-std::string TMRobotListener::extract_buffer_data(boost::asio::streambuf &t_buffer,
-                                                 size_t const t_byte_to_extract) noexcept {
-  if (t_byte_to_extract > 0) {
-    auto const buffer_begin = boost::asio::buffers_begin(t_buffer.data());
-    std::string const result{buffer_begin, buffer_begin + t_byte_to_extract};
-    t_buffer.consume(t_byte_to_extract);
-
-    return result;
-  }
-
-  return std::string{""};
+/**
+ * @details boost::asio::streambuf stores its input sequence contiguously, therefore the data can be viewed directly
+ */
+boost::string_ref TMRobotListener::view_buffer_data(boost::asio::streambuf const &t_buffer,
+                                                    size_t const t_byte_to_view) noexcept {
+  auto const data = t_buffer.data();
+  return boost::string_ref{boost::asio::buffer_cast<char const *>(data),
+                           std::min(t_byte_to_view, boost::asio::buffer_size(data))};
 }
 
 /**
@@ -82,8 +192,15 @@ std::string TMRobotListener::extract_buffer_data(boost::asio::streambuf &t_buffe
  *          that said, one thing we need to do is to make sure if we exit script, e.g., by sending ScriptExit(),
  *          current_task_handler_ is reset.
  *
- *          If there is no handler that is willing to handle the current listen node, then default_task_handler_ will
- *          generate the response, sending ScriptExit() immediately to TM robot.
+ *          If there is no handler that is willing to handle the current listen node, ScriptExit() is sent immediately
+ *          to TM robot, see ScriptExitHandler::script_exit.
+ *
+ *          Messages that fail length or checksum verification are counted and dropped before any handler sees them.
+ *
+ *          The time taken to parse the message, and to dispatch it to the handler, is recorded, so is the round trip
+ *          time of the request the message responds to.
+ *
+ *          Every valid message is published once the handler is done with it, see publish_response.
  *
  * @note    The buffer passed to async_read_until is already committed
  * @note    TM robot will send OK message even after ScriptExit()
@@ -91,53 +208,82 @@ std::string TMRobotListener::extract_buffer_data(boost::asio::streambuf &t_buffe
 void TMRobotListener::handle_read(boost::system::error_code const &t_err, size_t const t_byte_transfered) noexcept {
   using namespace boost::asio::placeholders;
 
-  if (not ros::ok()) {
+  if (this->stopping_) {
     return;
   }
 
   if (not t_err) {  // NOLINT, boost pre c++11 safe bool idiom
     if (t_byte_transfered > 0) {
-      auto const result        = this->extract_buffer_data(this->input_buffer_, t_byte_transfered);
-      auto const parsed_result = ::get_tokenized_result(result);
-      ROS_INFO_STREAM("Received: " << ::strip_crlf(result));
-
-      auto const id     = *boost::next(parsed_result.begin(), ID_INDEX);
-      auto const header = *parsed_result.begin();
-      if (not this->current_task_handler_) {
-        if (header == motion_function::TMSCT and id == TMR_INIT_MSG_ID) {
+      auto const read_at   = Clock::now();
+      auto const read_time = ros::Time::now();  // stamp of the published response, see publish_response
+      auto const result    = this->view_buffer_data(this->input_buffer_, t_byte_transfered);
+      auto const frame     = parse_frame(result);
+      auto const parsed_at = Clock::now();
+      auto const header    = latency_header(frame.header_);
+      this->frame_log_.push(FrameLog_t::Direction::Received, result);
+      this->record_latency(LatencyStage::Parse, header, this->current_handler_index_, parsed_at - read_at);
+      auto round_trip = Clock::duration::zero();
+
+      if (not frame.valid()) {
+        ++this->rejected_frames_;
+        ROS_WARN_STREAM_THROTTLE_NAMED(1.0, "tm_listener_node",
+                                       "Rejected corrupted message (" << this->rejected_frames_ << " in total)");
+      } else if (this->take_injected_response(frame)) {
+        // responds to a script injected through ~listener_cmd, the handler knows nothing about it
+      } else if (not this->current_task_handler_) {
+        FieldTokenizer fields{frame.payload_, ','};
+        boost::string_ref id;
+        if (frame.header_ == motion_function::TMSCT and fields.next(id) and id == TMR_INIT_MSG_ID) {
           // assign current handler to the one that satisfies the condition (match message)
-          auto const data = std::vector<std::string>{boost::next(parsed_result.begin(), SCRIPT_START_INDEX),
-                                                     boost::prior(parsed_result.end(), 1)};
-          ROS_INFO_STREAM("In Listener node, node message: " << data[0]);
-          auto const predicate = [&data](auto const &t_handler) {
-            return t_handler->start_task_handling(data) == Decision::Accept;
-          };
-          auto const matched = std::find_if(this->task_handlers_.begin(), this->task_handlers_.end(), predicate);
-
-          auto const cmd = [&]() {
-            if (matched != this->task_handlers_.end()) {
-              this->current_task_handler_ = *matched;
-              return this->current_task_handler_->generate_request();
+          auto const data = [&fields]() {
+            std::vector<std::string> ret_val;
+            for (boost::string_ref field; fields.next(field);) {
+              ret_val.emplace_back(field.to_string());
             }
-
-            ROS_WARN_NAMED("tm_listener_node", "tm_listener_node doesn't find any handler satisfies the condition.");
-            return this->default_task_handler_->generate_request();
+            return ret_val;
           }();
-          this->output_buffer_ = cmd->to_str();
+          ROS_INFO_STREAM("In Listener node, node message: " << (data.empty() ? "" : data[0]));
+          this->set_connection_state(ConnectionState::InListenNode);
+          auto const found             = this->find_task_handler(data);
+          this->current_handler_index_ = found;
+          this->current_task_handler_  = found == NO_HANDLER ? nullptr : this->task_handlers_[found].handler_;
+          this->record_latency(LatencyStage::Dispatch, header, found, Clock::now() - parsed_at);
+          if (not this->current_task_handler_) {
+            ROS_WARN_NAMED("tm_listener_node", "tm_listener_node doesn't find any handler satisfies the condition.");
+            this->enqueue_frame(ScriptExitHandler::script_exit());
+            this->end_task();
+          }
 
-          ROS_INFO_STREAM_NAMED("tm_listen_node", "Write msg: " << ::strip_crlf(this->output_buffer_));
-          boost::asio::async_write(this->listener_, boost::asio::buffer(this->output_buffer_),
-                                   boost::bind(&TMRobotListener::handle_write, this, error, bytes_transferred));
+          this->write_request();
         }
+      } else if (not this->current_task_handler_->handle_response(frame)) {
+        ++this->rejected_frames_;
+        ROS_WARN_STREAM_THROTTLE_NAMED(1.0, "tm_listener_node",
+                                       "Rejected unparsable message (" << this->rejected_frames_ << " in total)");
       } else {
-        this->current_task_handler_->handle_response(parsed_result);
+        auto const handler = this->current_handler_index_;
+        this->record_latency(LatencyStage::Dispatch, header, handler, Clock::now() - parsed_at);
+        round_trip = this->current_task_handler_->last_round_trip();
+        if (round_trip != Clock::duration::zero()) {
+          this->record_latency(LatencyStage::RoundTrip, header, handler, round_trip);
+        }
+
+        this->write_request();  // the handler may have something to say about the response
+      }
+
+      if (frame.valid()) {
+        this->publish_response(frame, round_trip, read_time);
       }
 
+      // the frame views the input buffer, it can only be consumed after the frame is handled
+      this->input_buffer_.consume(t_byte_transfered);
+
       // initiate another read process
-      boost::asio::async_read_until(this->listener_, this->input_buffer_, MESSAGE_END_BYTE,
-                                    boost::bind(&TMRobotListener::handle_read, this, error, bytes_transferred));
+      boost::asio::async_read_until(
+        this->listener_, this->input_buffer_, MESSAGE_END_BYTE,
+        this->strand_.wrap(boost::bind(&TMRobotListener::handle_read, this, error, bytes_transferred)));
     }
-  } else {
+  } else if (t_err != boost::asio::error::operation_aborted) {  // the socket is closed by whoever reconnects
     ROS_ERROR_STREAM_NAMED("tm_listener_node", "Read Error: " << t_err.message());
     ROS_ERROR_STREAM_NAMED("tm_socket_connection", "Read Error detected, reconnecting...");
 
@@ -145,26 +291,30 @@ void TMRobotListener::handle_read(boost::system::error_code const &t_err, size_t
   }
 }
 
+/**
+ * @details A write is never aborted half way by us, operation_aborted only happens if the socket is closed, in which
+ *          case whoever closed it is responsible for what comes next.
+ *
+ *          The write latency of a frame counts from its serialization, the time it waits in the queue included.
+ */
 void TMRobotListener::handle_write(boost::system::error_code const &t_err, size_t const /*t_byte_writtened*/) noexcept {
-  using namespace boost::asio::placeholders;
+  auto const written_at    = Clock::now();
+  this->write_in_progress_ = false;
+  for (auto &frame : this->in_flight_frames_) {
+    if (not t_err) {  // NOLINT, boost pre c++11 safe bool idiom
+      this->record_latency(LatencyStage::Write, frame.header_, frame.handler_, written_at - frame.queued_at_);
+    }
 
-  if (not ros::ok()) {
+    this->recycle_frame(frame);
+  }
+  this->in_flight_frames_.clear();
+
+  if (this->stopping_ or t_err == boost::asio::error::operation_aborted) {
     return;
   }
 
   if (not t_err) {  // NOLINT, boost pre c++11 safe bool idiom
-    if (this->current_task_handler_) {
-      auto const cmd       = this->current_task_handler_->generate_request();
-      this->output_buffer_ = cmd->to_str();
-      if (cmd->has_script_exit()) {
-        this->current_task_handler_.reset();
-      }
-
-      ROS_INFO_STREAM_COND_NAMED(not this->output_buffer_.empty(), "tm_listen_node",
-                                 "Write msg: " << ::strip_crlf(this->output_buffer_));
-      boost::asio::async_write(this->listener_, boost::asio::buffer(this->output_buffer_),
-                               boost::bind(&TMRobotListener::handle_write, this, error, bytes_transferred));
-    }
+    this->write_request();
   } else {
     ROS_ERROR_STREAM_NAMED("tm_listener_node", "Write Error: " << t_err.message());
     ROS_ERROR_STREAM_NAMED("tm_socket_connection", "Write Error detected, reconnecting...");
@@ -173,12 +323,128 @@ void TMRobotListener::handle_write(boost::system::error_code const &t_err, size_
   }
 }
 
-void TMRobotListener::listener_node() {
+void TMRobotListener::enqueue_frame(motion_function::BaseHeaderProductPtr const &t_cmd,
+                                    std::size_t const t_handler) noexcept {
+  if (t_cmd->empty()) {
+    return;
+  }
+
+  auto const serialize_at = Clock::now();
+  QueuedFrame frame;
+  frame.header_  = latency_header(t_cmd->header());
+  frame.handler_ = t_handler;
+  if (not t_cmd->prebuilt_frame().empty()) {
+    frame.prebuilt_ = t_cmd;
+  } else {
+    if (not this->free_frames_.empty()) {
+      frame.buffer_ = std::move(this->free_frames_.back());
+      this->free_frames_.pop_back();
+    }
+
+    t_cmd->serialize(frame.buffer_);
+  }
+
+  frame.queued_at_ = Clock::now();
+  this->record_latency(LatencyStage::Serialize, frame.header_, t_handler, frame.queued_at_ - serialize_at);
+  this->write_queue_.push_back(std::move(frame));
+  this->frame_log_.push(FrameLog_t::Direction::Sent, this->write_queue_.back().bytes());
+}
+
+void TMRobotListener::recycle_frame(QueuedFrame &t_frame) noexcept {
+  if (t_frame.prebuilt_) {  // no buffer is taken for prebuilt frame
+    t_frame.prebuilt_.reset();
+    return;
+  }
+
+  t_frame.buffer_.clear();
+  this->free_frames_.push_back(std::move(t_frame.buffer_));
+}
+
+/**
+ * @details A handler producing a burst, e.g. a trajectory split across several frames, gets all of them queued in
+ *          one go, the handler is asked again only after the queue drains. ScriptExit() ends the handling, no more
+ *          requests are generated afterwards.
+ *
+ *          Only the commands generated are timed, a handler saying it has nothing to send yet is not.
+ */
+void TMRobotListener::queue_request() noexcept {
+  while (this->current_task_handler_ and this->write_queue_.size() < this->max_queued_frames_) {
+    auto const handler      = this->current_handler_index_;
+    auto const generate_at  = Clock::now();
+    auto const cmd          = this->current_task_handler_->generate_request();
+    auto const generated_at = Clock::now();
+    if (cmd->has_script_exit()) {
+      this->end_task();
+    }
+
+    if (cmd->empty()) {
+      break;
+    }
+
+    this->record_latency(LatencyStage::Generate, latency_header(cmd->header()), handler, generated_at - generate_at);
+    this->enqueue_frame(cmd, handler);
+  }
+}
+
+/**
+ * @details write_buffers_ points into the frames of in_flight_frames_, which is a deque, so that queuing a frame never
+ *          moves the ones before it, whether or not their buffers are stored inline.
+ */
+void TMRobotListener::flush_write_queue() noexcept {
   using namespace boost::asio::placeholders;
 
-  this->listener_.async_connect(this->tm_robot_, boost::bind(&TMRobotListener::handle_connection, this, error));
-  this->ros_heartbeat_timer_.expires_from_now(HEARTBEAT_INTERVAL());
-  this->ros_heartbeat_timer_.async_wait(boost::bind(&TMRobotListener::check_ros_heartbeat, this, error));
+  if (this->write_in_progress_ or this->write_queue_.empty()) {
+    return;
+  }
+
+  this->write_buffers_.clear();
+  this->urgent_frames_ = 0;
+  while (not this->write_queue_.empty()) {
+    this->in_flight_frames_.push_back(std::move(this->write_queue_.front()));
+    this->write_queue_.pop_front();
+    auto const bytes = this->in_flight_frames_.back().bytes();
+    this->write_buffers_.emplace_back(boost::asio::buffer(bytes.data(), bytes.size()));
+  }
+
+  this->write_in_progress_ = true;
+  boost::asio::async_write(
+    this->listener_, this->write_buffers_,
+    this->strand_.wrap(boost::bind(&TMRobotListener::handle_write, this, error, bytes_transferred)));
+}
+
+/**
+ * @details An idle handler is not asked in a loop, which would keep the I/O thread busy for as long as the handler
+ *          waits, e.g., for TM robot to respond. Responses, writes and wake_up() ask the handler right away, the timer
+ *          only bounds the wait for handlers that depend on anything else.
+ */
+void TMRobotListener::write_request() noexcept {
+  if (this->write_in_progress_) {
+    return;
+  }
+
+  this->queue_request();
+  this->flush_write_queue();
+  this->queue_request();
+
+  if (not this->write_in_progress_ and this->current_task_handler_ and not this->current_task_handler_->generating() and
+      not this->poll_pending_) {
+    this->poll_pending_ = true;
+    this->poll_timer_.expires_from_now(this->handler_poll_period_);
+    this->poll_timer_.async_wait(this->strand_.wrap([this](boost::system::error_code const &t_err) {
+      this->poll_pending_ = false;
+      if (not t_err and not this->stopping_) {
+        this->write_request();
+      }
+    }));
+  }
+}
+
+void TMRobotListener::async_start() noexcept {
+  this->strand_.post([this]() { this->connect(); });
+}
+
+void TMRobotListener::listener_node() {
+  this->async_start();
 
   try {
     this->io_service_.run();
@@ -187,31 +453,457 @@ void TMRobotListener::listener_node() {
   }
 }
 
+/**
+ * @details ros::spin() returns once ROS is shutdown, which is the only event the listener needs to know about ROS, the
+ *          shutdown is then posted to the io service, nothing is polled.
+ */
 void TMRobotListener::start() {
   if (ros::ok()) {
     this->listener_node_thread_ = boost::thread{&TMRobotListener::listener_node, this};
   }
 
   ros::spin();
+  this->stop();
 
   if (this->listener_node_thread_.joinable()) {
     this->listener_node_thread_.join();
   }
 }
 
+/**
+ * @details Closing the socket and cancelling the timers abort every pending operation, the handlers see stopping_ and
+ *          return without initiating new ones, io_service::run() then returns since it runs out of work.
+ */
 void TMRobotListener::stop() noexcept {
-  boost::system::error_code ignore_error_code;
-  this->listener_.close(ignore_error_code);
-  this->ros_heartbeat_timer_.cancel();
+  this->strand_.post([this]() {
+    this->stopping_ = true;
+
+    boost::system::error_code ignore_error_code;
+    this->listener_.close(ignore_error_code);
+    this->reconnect_timer_.cancel(ignore_error_code);
+    this->connect_timer_.cancel(ignore_error_code);
+    this->poll_timer_.cancel(ignore_error_code);
+    this->set_connection_state(ConnectionState::Disconnected);
+  });
 }
 
-void TMRobotListener::reconnect() noexcept {
-  using namespace boost::asio::placeholders;
+/**
+ * @details Frames are printed at debug level, set logger ros.tm_robot_listener.tm_frame_log to debug to see them
+ */
+void TMRobotListener::drain_frame_log(ros::WallTimerEvent const & /*unused*/) noexcept {
+  this->frame_log_.drain([](FrameLog_t::Entry const &t_entry) {
+    auto const stamp     = std::chrono::duration<double>(t_entry.stamp_.time_since_epoch()).count();
+    auto const direction = t_entry.direction_ == FrameLog_t::Direction::Received ? "Received: " : "Sent: ";
+    ROS_DEBUG_STREAM_NAMED("tm_frame_log", std::fixed << std::setprecision(6) << '[' << stamp << "] " << direction
+                                             << t_entry.frame() << (t_entry.truncated() ? "..." : ""));
+  });
+
+  if (auto const dropped = this->frame_log_.take_dropped()) {
+    ROS_WARN_STREAM_NAMED("tm_frame_log", dropped << " frames are not logged since the frame log is full");
+  }
+}
+
+/**
+ * @details The messages are published through shared pointers, subscribers in the same process, e.g. nodelets, get
+ *          the pointer without serialization.
+ *
+ *          The messages are stamped with the time the frame is read, so that the time taken to dispatch it to the
+ *          handler, and to generate the next request, doesn't show up in the stamp.
+ */
+void TMRobotListener::publish_response(FrameView const &t_frame, Clock::duration const t_round_trip,
+                                       ros::Time const &t_read_time) noexcept {
+  using std::chrono::duration_cast;
+  auto const round_trip = ros::Duration{}.fromNSec(duration_cast<std::chrono::nanoseconds>(t_round_trip).count());
+
+  if (t_frame.header_ == motion_function::TMSCT and this->tmsct_pub_.getNumSubscribers() != 0) {
+    TMSCTResponse resp;
+    if (parse_response(t_frame, resp)) {
+      auto msg   = boost::make_shared<TMSCTResponseStamped>();
+      msg->stamp = t_read_time;
+      msg->id    = std::move(resp.id_);
+      msg->ok    = resp.script_result_;
+      msg->abnormal_lines.assign(resp.abnormal_line_.begin(), resp.abnormal_line_.end());
+      msg->round_trip = round_trip;
+      this->tmsct_pub_.publish(boost::shared_ptr<TMSCTResponseStamped const>{std::move(msg)});
+    }
+  } else if (t_frame.header_ == motion_function::TMSTA and this->tmsta_pub_.getNumSubscribers() != 0) {
+    TMSTAResponse resp;
+    if (parse_response(t_frame, resp)) {
+      auto msg        = boost::make_shared<TMSTAResponseStamped>();
+      msg->stamp      = t_read_time;
+      msg->subcmd     = resp.subcmd_;
+      msg->data       = std::move(resp.data_);
+      msg->round_trip = round_trip;
+      this->tmsta_pub_.publish(boost::shared_ptr<TMSTAResponseStamped const>{std::move(msg)});
+    }
+  } else if (t_frame.header_ == motion_function::CPERR and this->cperr_pub_.getNumSubscribers() != 0) {
+    CPERRResponse resp;
+    if (parse_response(t_frame, resp)) {
+      auto msg        = boost::make_shared<CPERRResponseStamped>();
+      msg->stamp      = t_read_time;
+      msg->error_code = static_cast<int>(resp.err_);
+      msg->round_trip = round_trip;
+      this->cperr_pub_.publish(boost::shared_ptr<CPERRResponseStamped const>{std::move(msg)});
+    }
+  }
+}
+
+/**
+ * @details The script is verified by the thread of listener_cmd_queue_, the I/O thread only queues it, waiting for it
+ *          never blocks the ROS spinner thread. The caller is answered once it is queued, not when TM robot responds,
+ *          the response is only published, see take_injected_response.
+ *
+ *          A script that is not queued in time is abandoned, the I/O thread no longer queues it once it gets there,
+ *          so that a caller retrying after the timeout never sends the script twice. Whichever side claims the script
+ *          first wins.
+ */
+bool TMRobotListener::handle_listener_cmd(ListenerCmd::Request &t_req, ListenerCmd::Response &t_res) noexcept {
+  static constexpr std::chrono::seconds QUEUE_TIMEOUT{1};
+
+  motion_function::BaseHeaderProductPtr cmd;
+  try {
+    cmd = motion_function::raw_frame(t_req.req);
+  } catch (std::invalid_argument const &t_err) {
+    t_res.res = t_err.what();
+    return true;
+  }
+
+  auto const urgent = t_req.priority >= ListenerCmd::Request::PRIORITY_HIGH;
+  auto result       = std::make_shared<std::promise<std::string>>();
+  auto claimed      = std::make_shared<std::atomic<bool>>(false);
+  auto queued       = result->get_future();
+  this->strand_.post([this, cmd, urgent, result, claimed]() {
+    if (not claimed->exchange(true)) {
+      result->set_value(this->inject_command(cmd, urgent));
+    }
+  });
+
+  if (queued.wait_for(QUEUE_TIMEOUT) != std::future_status::ready and not claimed->exchange(true)) {
+    t_res.res = "timed out waiting for the I/O thread, the script is not sent";
+    return true;
+  }
+
+  auto const error = queued.get();
+  t_res.res        = error.empty() ? "OK" : error;
+  return true;
+}
+
+/**
+ * @details Scripts of normal priority are refused while the write queue is full, like the ones generated by handlers,
+ *          scripts of high priority are always queued. A script exiting the listen node ends the handling of the
+ *          current handler, the same way ScriptExit() generated by the handler does.
+ */
+std::string TMRobotListener::inject_command(motion_function::BaseHeaderProductPtr const &t_cmd,
+                                            bool const t_urgent) noexcept {
+  if (this->stopping_) {
+    return "listener is stopped";
+  }
+
+  if (not this->current_task_handler_) {
+    return "not in listen node";
+  }
+
+  if (not t_urgent and this->write_queue_.size() >= this->max_queued_frames_) {
+    return "write queue is full";
+  }
+
+  this->enqueue_frame(t_cmd);
+  if (t_cmd->header() == motion_function::TMSCT or t_cmd->header() == motion_function::TMSTA) {
+    this->injected_in_flight_.push_back(
+      InjectedRequest{t_cmd->header().to_string(), t_cmd->response_key().to_string(), Clock::now()});
+  }
+
+  if (t_urgent) {
+    auto frame = std::move(this->write_queue_.back());
+    this->write_queue_.pop_back();
+    this->write_queue_.insert(this->write_queue_.begin() + static_cast<std::ptrdiff_t>(this->urgent_frames_++),
+                              std::move(frame));
+  }
+
+  if (t_cmd->has_script_exit()) {
+    this->end_task();
+  }
+
+  this->write_request();
+  return {};
+}
 
+/**
+ * @details TMSCT and TMSTA responses are matched by TMSCT ID and TMSTA sub command, the same way the handlers match
+ *          theirs. CPERR carries neither, it is taken if the oldest injected script is older than every request of
+ *          current_task_handler_, since TM robot processes requests in order. Injected scripts that are not responded
+ *          within ListenerHandle::DEFAULT_RESPONSE_TIMEOUT are forgotten.
+ */
+bool TMRobotListener::take_injected_response(FrameView const &t_frame) noexcept {
+  auto const expired_before = Clock::now() - ListenerHandle::DEFAULT_RESPONSE_TIMEOUT;
+  while (not this->injected_in_flight_.empty() and this->injected_in_flight_.front().queued_at_ <= expired_before) {
+    this->injected_in_flight_.pop_front();
+  }
+
+  if (this->injected_in_flight_.empty()) {
+    return false;
+  }
+
+  auto match = this->injected_in_flight_.end();
+  if (t_frame.header_ == motion_function::CPERR) {
+    auto const &handler = this->current_task_handler_;
+    if (not handler or this->injected_in_flight_.front().queued_at_ < handler->oldest_in_flight()) {
+      match = this->injected_in_flight_.begin();
+    }
+  } else {
+    FieldTokenizer fields{t_frame.payload_, ','};
+    boost::string_ref key;
+    if (fields.next(key) and not(t_frame.header_ == motion_function::TMSCT and key == TMR_INIT_MSG_ID)) {
+      match = std::find_if(this->injected_in_flight_.begin(), this->injected_in_flight_.end(),
+                           [&t_frame, key](InjectedRequest const &t_request) {
+                             return t_request.header_ == t_frame.header_ and t_request.key_ == key;
+                           });
+    }
+  }
+
+  if (match == this->injected_in_flight_.end()) {
+    return false;
+  }
+
+  this->injected_in_flight_.erase(match);
+  return true;
+}
+
+std::uint8_t TMRobotListener::latency_header(boost::string_ref const t_header) noexcept {
+  if (t_header == motion_function::TMSCT) {
+    return 0;
+  }
+
+  if (t_header == motion_function::TMSTA) {
+    return 1;
+  }
+
+  return t_header == motion_function::CPERR ? 2 : 3;
+}
+
+void TMRobotListener::record_latency(LatencyStage const t_stage, std::uint8_t const t_header,
+                                     std::size_t const t_handler, Clock::duration const t_latency) noexcept {
+  using std::chrono::duration_cast;
+  if (not this->latency_samples_.try_push(
+        LatencySample{t_stage, t_header, t_handler, duration_cast<std::chrono::nanoseconds>(t_latency)})) {
+    this->dropped_latency_samples_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+/**
+ * @details Every sample is recorded into the histograms of its header, and of its handler if there is one. The
+ *          histograms are created on the first sample, most handlers never get any.
+ */
+void TMRobotListener::collect_latency(ros::WallTimerEvent const & /*unused*/) noexcept {
+  auto const histograms_of = [](std::unique_ptr<LatencyHistograms_t> &t_histograms) -> LatencyHistograms_t & {
+    if (not t_histograms) {
+      t_histograms = std::make_unique<LatencyHistograms_t>();
+    }
+
+    return *t_histograms;
+  };
+
+  for (auto sample = this->latency_samples_.front(); sample != nullptr; sample = this->latency_samples_.front()) {
+    auto const stage = static_cast<std::size_t>(sample->stage_);
+    histograms_of(this->header_latency_[sample->header_])[stage].record(sample->latency_);
+    if (sample->handler_ < this->handler_latency_.size()) {
+      histograms_of(this->handler_latency_[sample->handler_])[stage].record(sample->latency_);
+    }
+
+    this->latency_samples_.pop();
+  }
+
+  if (Clock::now() >= this->next_latency_report_) {
+    this->next_latency_report_ = Clock::now() + this->latency_report_period_;
+    this->report_latency();
+  }
+}
+
+/**
+ * @details The summary is logged at info level by the logger ros.tm_robot_listener.tm_latency, one line per handler
+ *          or header that has anything recorded since the previous report.
+ */
+void TMRobotListener::report_latency() noexcept {
+  auto const to_us = [](std::chrono::nanoseconds const t_latency) {
+    return std::chrono::duration<double, std::micro>{t_latency}.count();
+  };
+
+  auto const publish = this->latency_pub_.getNumSubscribers() != 0;
+  LatencyReport report;
+  report.stamp           = ros::Time::now();
+  report.dropped_samples = this->dropped_latency_samples_.exchange(0, std::memory_order_relaxed);
+
+  auto const report_source = [&](std::string const &t_source, std::unique_ptr<LatencyHistograms_t> &t_histograms) {
+    if (not t_histograms) {
+      return;
+    }
+
+    std::ostringstream summary;
+    for (std::size_t stage = 0; stage < t_histograms->size(); ++stage) {
+      auto &histogram = (*t_histograms)[stage];
+      if (histogram.count() == 0) {
+        continue;
+      }
+
+      summary << ' ' << LATENCY_STAGES[stage] << " (n " << histogram.count() << ") p50 "
+              << to_us(histogram.percentile(0.5)) << " p99 " << to_us(histogram.percentile(0.99)) << " max "
+              << to_us(histogram.max());
+
+      if (publish) {
+        LatencyHistogram msg;
+        msg.source  = t_source;
+        msg.stage   = LATENCY_STAGES[stage];
+        msg.count   = histogram.count();
+        msg.mean_us = to_us(histogram.mean());
+        msg.p50_us  = to_us(histogram.percentile(0.5));
+        msg.p90_us  = to_us(histogram.percentile(0.9));
+        msg.p99_us  = to_us(histogram.percentile(0.99));
+        msg.max_us  = to_us(histogram.max());
+        report.histograms.push_back(std::move(msg));
+      }
+
+      histogram.reset();
+    }
+
+    if (not summary.str().empty()) {
+      ROS_INFO_STREAM_NAMED("tm_latency", t_source << " latency (us):" << summary.str());
+    }
+  };
+
+  for (std::size_t header = 0; header < this->header_latency_.size(); ++header) {
+    report_source(LATENCY_HEADERS[header], this->header_latency_[header]);
+  }
+
+  for (std::size_t handler = 0; handler < this->handler_latency_.size(); ++handler) {
+    report_source(this->task_handlers_[handler].name_, this->handler_latency_[handler]);
+  }
+
+  if (report.dropped_samples != 0) {
+    ROS_WARN_STREAM_NAMED("tm_latency",
+                          report.dropped_samples << " latency samples are dropped since the queue is full");
+  }
+
+  if (publish) {
+    this->latency_pub_.publish(report);
+  }
+}
+
+/**
+ * @details Only the handlers that declare the node message, and the ones that declare nothing, are asked, in the order
+ *          they are loaded, see detail::HandlerIndex. A lazy handler is created here, the first time one of its
+ *          messages is seen. Handlers that fail to be created are skipped.
+ */
+std::size_t TMRobotListener::find_task_handler(std::vector<std::string> const &t_data) noexcept {
+  static std::string const NO_MESSAGE;
+
+  auto const create = [this](std::string const &t_name) { return this->create_task_handler(t_name); };
+  auto const accept = [&t_data](TMTaskHandler const &t_handler) {
+    return t_handler->start_task_handling(t_data) == Decision::Accept;
+  };
+
+  return this->task_handlers_.find(t_data.empty() ? NO_MESSAGE : t_data.front(), create, accept);
+}
+
+/**
+ * @details pluginlib::ClassLoader is not safe to be used by several threads at once, handlers are created one by one.
+ *          Startup time is saved by deferring the lazy handlers instead, whose messages are given in the parameter so
+ *          that they can be indexed without being created.
+ */
+void TMRobotListener::load_task_handlers() noexcept {
+  auto const start_time    = std::chrono::steady_clock::now();
+  auto const plugin_names  = this->private_nh_.param("listener_handles", std::vector<std::string>{});
+  auto const lazy_messages = this->lazy_handler_messages();
+  ROS_DEBUG_STREAM_NAMED("tm_robot_listener", "plugin num: " << plugin_names.size());
+
+  auto const create = [this](std::string const &t_name) { return this->create_task_handler(t_name); };
+  auto const loaded = this->task_handlers_.load(plugin_names, lazy_messages, create);
+
+  using std::chrono::duration_cast;
+  auto const elapsed = duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time);
+  ROS_INFO_STREAM_NAMED("tm_robot_listener", "Loaded " << loaded << " listener handle(s), deferred "
+                                                       << this->task_handlers_.deferred_count() << ", in "
+                                                       << elapsed.count() / 1000.0 << " ms");
+}
+
+TMRobotListener::TMTaskHandler TMRobotListener::create_task_handler(std::string const &t_name) noexcept {
+  auto const start_time = std::chrono::steady_clock::now();
+  TMTaskHandler ret_val;
+  try {
+    ret_val = this->class_loader_.createInstance(t_name);
+  } catch (std::exception const &t_err) {
+    ROS_ERROR_STREAM_NAMED("tm_robot_listener", "Failed to load " << t_name << ": " << t_err.what());
+    return nullptr;
+  }
+
+  ret_val->attach(this->handler_context());
+
+  using std::chrono::duration_cast;
+  auto const elapsed = duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time);
+  ROS_DEBUG_STREAM_NAMED("tm_robot_listener", "Loaded " << t_name << " in " << elapsed.count() / 1000.0 << " ms");
+  return ret_val;
+}
+
+/**
+ * @details Malformed entries are reported and ignored, the handler is then loaded at startup.
+ */
+detail::LazyMessages TMRobotListener::lazy_handler_messages() const noexcept {
+  detail::LazyMessages ret_val;
+
+  XmlRpc::XmlRpcValue param;
+  if (not this->private_nh_.getParam("lazy_listener_handles", param)) {
+    return ret_val;
+  }
+
+  std::vector<int> malformed;
+  if (not detail::parse_lazy_handles(param, ret_val, malformed)) {
+    ROS_ERROR_NAMED("tm_robot_listener", "lazy_listener_handles must be a list, ignored");
+  }
+
+  for (auto const index : malformed) {
+    ROS_ERROR_STREAM_NAMED("tm_robot_listener", "lazy_listener_handles[" << index << "] is malformed, ignored");
+  }
+
+  return ret_val;
+}
+
+TMRobotListener::~TMRobotListener() {
+  this->worker_work_.reset();
+  this->worker_service_.stop();
+  this->workers_.join_all();
+}
+
+/**
+ * @details The handler is woken up through strand_, the write process then asks it again, unless the listener is
+ *          stopped meanwhile.
+ */
+HandlerContext TMRobotListener::handler_context() noexcept {
+  auto wake_up = [this]() {
+    this->strand_.post([this]() {
+      if (not this->stopping_) {
+        this->write_request();
+      }
+    });
+  };
+
+  auto post_work = [this](std::function<void()> t_job) { this->worker_service_.post(std::move(t_job)); };
+  return HandlerContext{std::move(wake_up), std::move(post_work)};
+}
+
+/**
+ * @details A connection lost is retried after the backoff delay as well, but the first attempt comes soon, since the
+ *          delay is reset by the connection that is lost.
+ */
+void TMRobotListener::reconnect() noexcept {
   this->current_task_handler_.reset();
-  boost::system::error_code ignore_error_code;
-  this->listener_.close(ignore_error_code);
-  this->listener_.async_connect(this->tm_robot_, boost::bind(&TMRobotListener::handle_connection, this, error));
+  this->current_handler_index_ = NO_HANDLER;
+  for (auto &frame : this->write_queue_) {
+    this->recycle_frame(frame);
+  }
+  this->write_queue_.clear();
+  this->urgent_frames_ = 0;
+  this->injected_in_flight_.clear();
+
+  this->schedule_reconnect();
 }
 
 }  // namespace tm_robot_listener
\ No newline at end of file
@@ -0,0 +1,54 @@
+#include "tm_robot_listener/tm_robot_listener_manager.hpp"
+
+namespace tm_robot_listener {
+
+TMRobotListenerManager::TMRobotListenerManager(ros::NodeHandle t_nh)
+  : private_nh_{std::move(t_nh)},
+    thread_count_{static_cast<std::size_t>(
+      std::max(1, this->private_nh_.param("io_threads", static_cast<int>(DEFAULT_THREAD_COUNT))))} {
+  auto const robot_names = this->private_nh_.param("robots", std::vector<std::string>{});
+  for (auto const &name : robot_names) {
+    ros::NodeHandle robot_nh{this->private_nh_, name};
+    auto const ip = robot_nh.param("ip", std::string{TMRobotListener::DEFAULT_IP_ADDRESS});
+    ROS_INFO_STREAM_NAMED("tm_robot_listener", "Prepare connection: " << name << " (" << ip << ")");
+
+    this->listeners_.emplace_back(std::make_unique<TMRobotListener>(this->io_service_, robot_nh, ip));
+  }
+}
+
+void TMRobotListenerManager::run_io_service() noexcept {
+  try {
+    this->io_service_.run();
+  } catch (std::exception &e) {
+    ROS_ERROR_STREAM_COND_NAMED(ros::ok(), "tm_listener_connection", "Exception: " << e.what());
+  }
+}
+
+/**
+ * @details The io service runs out of work only after every listener is stopped, hence the threads are joined after
+ *          ros::spin() returns and stop() is called.
+ */
+void TMRobotListenerManager::start() {
+  if (ros::ok()) {
+    for (auto &listener : this->listeners_) {
+      listener->async_start();
+    }
+
+    for (std::size_t i = 0; i < this->thread_count_; ++i) {
+      this->io_threads_.create_thread([this]() { this->run_io_service(); });
+    }
+  }
+
+  ros::spin();
+  this->stop();
+
+  this->io_threads_.join_all();
+}
+
+void TMRobotListenerManager::stop() noexcept {
+  for (auto &listener : this->listeners_) {
+    listener->stop();
+  }
+}
+
+}  // namespace tm_robot_listener
@@ -0,0 +1,15 @@
+#include "tm_robot_listener/tm_robot_listener_manager.hpp"
+
+int main(int argc, char **argv) {
+  ros::init(argc, argv, "tm_robot_listener_manager");
+
+  tm_robot_listener::TMRobotListenerManager manager;
+  if (manager.robot_count() == 0) {
+    ROS_ERROR_NAMED("tm_robot_listener", "No robot is configured, see param ~robots");
+    return 1;
+  }
+
+  manager.start();
+
+  return 0;
+}
@@ -0,0 +1,41 @@
+#include "tm_robot_listener/tm_robot_listener_nodelet.hpp"
+
+#include <pluginlib/class_list_macros.h>
+
+namespace tm_robot_listener {
+
+/**
+ * @details onInit must return quickly, the connection is initiated here, but established on the io thread.
+ */
+void TMRobotListenerNodelet::onInit() {
+  auto &private_nh = this->getPrivateNodeHandle();
+  auto const ip    = private_nh.param("ip", std::string{TMRobotListener::DEFAULT_IP_ADDRESS});
+  NODELET_INFO_STREAM("Prepare connection: " << ip);
+
+  this->listener_ = std::make_unique<TMRobotListener>(this->io_service_, private_nh, ip);
+  this->listener_->async_start();
+  this->io_thread_ = boost::thread{[this]() {
+    try {
+      this->io_service_.run();
+    } catch (std::exception &e) {
+      NODELET_ERROR_STREAM_COND(ros::ok(), "Exception: " << e.what());
+    }
+  }};
+}
+
+/**
+ * @details The io service runs out of work once the listener is stopped, see TMRobotListener::stop.
+ */
+TMRobotListenerNodelet::~TMRobotListenerNodelet() {
+  if (this->listener_) {
+    this->listener_->stop();
+  }
+
+  if (this->io_thread_.joinable()) {
+    this->io_thread_.join();
+  }
+}
+
+}  // namespace tm_robot_listener
+
+PLUGINLIB_EXPORT_CLASS(tm_robot_listener::TMRobotListenerNodelet, nodelet::Nodelet)
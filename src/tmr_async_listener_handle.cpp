@@ -0,0 +1,75 @@
+#include "tmr_listener_handle/tmr_async_listener_handle.hpp"
+
+namespace tm_robot_listener {
+
+/**
+ * @details The handler is only ever asked by one thread, the I/O thread, so the stage needs no compare and swap: only
+ *          the I/O thread moves it out of Idle and Ready, only the worker moves it out of Generating.
+ *
+ *          A command generated for a previous task is dropped, and the generation starts over for the current one.
+ */
+motion_function::BaseHeaderProductPtr AsyncListenerHandle::generate_cmd(MessageStatus const t_prev_response) {
+  switch (this->stage_.load(std::memory_order_acquire)) {
+    case Stage::Generating:
+      return motion_function::empty_command_list();
+    case Stage::Ready: {
+      auto ret_val = std::move(this->result_);
+      this->stage_.store(Stage::Idle, std::memory_order_release);
+      if (this->result_epoch_ == this->task_epoch_.load()) {
+        return ret_val ? ret_val : motion_function::empty_command_list();
+      }
+      break;
+    }
+    case Stage::Idle:
+      break;
+  }
+
+  this->stage_.store(Stage::Generating, std::memory_order_release);
+
+  auto const epoch = this->task_epoch_.load();
+  auto const& post = this->context().post_work_;
+  if (not post) {
+    this->generate_in_background(t_prev_response, epoch);
+    return this->generate_cmd(t_prev_response);
+  }
+
+  post([this, t_prev_response, epoch]() { this->generate_in_background(t_prev_response, epoch); });
+  return motion_function::empty_command_list();
+}
+
+/**
+ * @details An exception thrown by the derived class is not allowed to reach the worker pool, it is treated as if
+ *          nothing is generated.
+ *
+ *          The command is published with the epoch it is generated for, whether it is stale is decided by the I/O
+ *          thread when it takes the command, see generate_cmd and task_started.
+ */
+void AsyncListenerHandle::generate_in_background(MessageStatus const t_prev_response,
+                                                 std::uint64_t const t_epoch) noexcept {
+  motion_function::BaseHeaderProductPtr result;
+  try {
+    result = this->generate_cmd_async(t_prev_response);
+  } catch (...) {
+    result.reset();
+  }
+
+  this->result_       = std::move(result);
+  this->result_epoch_ = t_epoch;
+  this->stage_.store(Stage::Ready, std::memory_order_release);
+  this->wake_up();
+}
+
+/**
+ * @details A command that is ready but not yet taken belongs to the previous task, it is dropped. A command still being
+ *          generated is dropped once it is ready, see generate_in_background.
+ */
+void AsyncListenerHandle::task_started() noexcept {
+  ++this->task_epoch_;
+
+  if (this->stage_.load(std::memory_order_acquire) == Stage::Ready) {
+    this->result_.reset();
+    this->stage_.store(Stage::Idle, std::memory_order_release);
+  }
+}
+
+}  // namespace tm_robot_listener
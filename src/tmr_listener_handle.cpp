@@ -1,75 +1,233 @@
-#include <boost/range/algorithm_ext.hpp>
+#include <algorithm>
+#include <iterator>
+#include <boost/lexical_cast.hpp>
 
 #include "tmr_listener_handle/tmr_listener_handle.hpp"
 
 namespace {
 
-auto get_tokenized_result(std::string const& t_input) noexcept {
-  auto const res = boost::tokenizer<boost::char_separator<char>>(t_input, boost::char_separator<char>(";"));
-  return std::vector<std::string>(res.begin(), res.end());
+inline bool to_int(boost::string_ref const& t_field, int& t_value) noexcept {
+  return boost::conversion::try_lexical_convert(t_field.data(), t_field.size(), t_value);
 }
 
 }  // namespace
 
 namespace tm_robot_listener {
 
+constexpr std::chrono::seconds ListenerHandle::DEFAULT_RESPONSE_TIMEOUT;
+
+/**
+ * @details Accepting the task starts a new conversation with TM robot, nothing is in flight at this point.
+ */
 Decision ListenerHandle::start_task_handling(std::vector<std::string> const& t_data) noexcept {
   auto const ret_val = this->start_task(t_data);
-  this->responded_   = ret_val == Decision::Accept ? MessageStatus::Responded : MessageStatus::NotYetRespond;
+  if (ret_val == Decision::Accept) {
+    this->clear_in_flight();
+    this->task_started();
+  }
 
   return ret_val;
 }
 
+void ListenerHandle::handle_connection_state(ConnectionState const t_state) noexcept {
+  if (t_state == ConnectionState::Disconnected) {
+    this->clear_in_flight();
+  }
+
+  this->connection_state_changed(t_state);
+}
+
 /**
- * @details If the command is not empty, then the responsded_ is set to false, indicating that we are waiting for new
- *          responses from the server. Otherwise, the response remains the same.
+ * @details If the command is not empty, it is recorded in the in-flight table, until TM robot responds to it, or it
+ *          expires, see set_response_timeout. The handler is informed MessageStatus::Responded only if every request
+ *          is responded.
  */
 motion_function::BaseHeaderProductPtr ListenerHandle::generate_request() noexcept {
-  auto const ret_val = this->generate_cmd(this->responded_);
+  this->expire_in_flight();
+  auto const status  = this->in_flight_count() == 0 ? MessageStatus::Responded : MessageStatus::NotYetRespond;
+  auto const ret_val = this->generate_cmd(status);
 
   if (not ret_val->empty()) {
-    this->responded_ = MessageStatus::NotYetRespond;
+    auto const header = ret_val->header();
+    auto& table = header == motion_function::TMSTA ? this->tmsta_in_flight_ : this->tmsct_in_flight_;
+    table.emplace(ret_val->response_key().to_string(),
+                  PendingRequest{this->request_sequence_++, std::chrono::steady_clock::now()});
   }
 
   return ret_val;
 }
 
-void ListenerHandle::handle_response(std::vector<std::string> const& t_response) noexcept {
-  this->responded_ = MessageStatus::Responded;
+void ListenerHandle::expire_in_flight() noexcept {
+  if (this->response_timeout_ == std::chrono::steady_clock::duration::zero()) {
+    return;
+  }
 
-  auto const header     = t_response.front();
-  auto const data_begin = std::next(t_response.begin(), 2);
-  auto const data_end   = std::prev(t_response.end());
+  auto const expired_before = std::chrono::steady_clock::now() - this->response_timeout_;
+  for (auto* table : {&this->tmsct_in_flight_, &this->tmsta_in_flight_}) {
+    for (auto entry = table->begin(); entry != table->end();) {
+      entry = entry->second.generated_at_ <= expired_before ? table->erase(entry) : std::next(entry);
+    }
+  }
+}
 
-  if (header == motion_function::TMSTA) {
-    TMSTAResponse const resp{boost::lexical_cast<int>(*data_begin),
-                             std::vector<std::string>(std::next(data_begin), data_end)};
-    this->response_msg(resp);
-  } else if (header == motion_function::TMSCT) {
-    using namespace boost::range;
-    using namespace boost::adaptors;
+std::chrono::steady_clock::time_point ListenerHandle::oldest_in_flight() const noexcept {
+  auto ret_val = std::chrono::steady_clock::time_point::max();
+  for (auto const* table : {&this->tmsct_in_flight_, &this->tmsta_in_flight_}) {
+    for (auto const& entry : *table) {
+      ret_val = std::min(ret_val, entry.second.generated_at_);
+    }
+  }
 
-    auto const result       = get_tokenized_result(*(std::next(data_begin)));
-    auto const abnormal_str = std::vector<std::string>{std::next(result.begin()), result.end()};
-    auto const line_num     = abnormal_str | transformed(boost::lexical_cast<int, std::string>);
+  return ret_val;
+}
 
-    TMSCTResponse const resp{*data_begin, result[0] == "OK", std::vector<int>{line_num.begin(), line_num.end()}};
+std::chrono::steady_clock::duration ListenerHandle::take_in_flight(InFlightTable& t_table,
+                                                                   boost::string_ref const t_key) noexcept {
+  auto const found = t_table.find(t_key);
+  if (found == t_table.end()) {
+    return std::chrono::steady_clock::duration::zero();
+  }
 
-    this->response_msg(resp);
-  } else if (header == motion_function::CPERR) {
-    auto const err = [](std::string const& t_data) {
-      if (t_data == "F1") {
-        return ErrorCode::NotInListenNode;
-      }
+  auto const ret_val = std::chrono::steady_clock::now() - found->second.generated_at_;
+  t_table.erase(found);
+  return ret_val;
+}
+
+std::chrono::steady_clock::duration ListenerHandle::take_oldest_in_flight() noexcept {
+  auto const by_sequence = [](auto const& t_lhs, auto const& t_rhs) {
+    return t_lhs.second.sequence_ < t_rhs.second.sequence_;
+  };
+
+  auto const oldest_tmsct = std::min_element(this->tmsct_in_flight_.begin(), this->tmsct_in_flight_.end(), by_sequence);
+  auto const oldest_tmsta = std::min_element(this->tmsta_in_flight_.begin(), this->tmsta_in_flight_.end(), by_sequence);
+
+  auto const take = [](InFlightTable& t_table, InFlightTable::iterator const t_entry) {
+    auto const ret_val = std::chrono::steady_clock::now() - t_entry->second.generated_at_;
+    t_table.erase(t_entry);
+    return ret_val;
+  };
 
-      return static_cast<ErrorCode>(boost::lexical_cast<int>(t_data));
-    }(*data_begin);
+  if (oldest_tmsct != this->tmsct_in_flight_.end() and
+      (oldest_tmsta == this->tmsta_in_flight_.end() or by_sequence(*oldest_tmsct, *oldest_tmsta))) {
+    return take(this->tmsct_in_flight_, oldest_tmsct);
+  }
+
+  if (oldest_tmsta != this->tmsta_in_flight_.end()) {
+    return take(this->tmsta_in_flight_, oldest_tmsta);
+  }
 
-    CPERRResponse const resp{err};
+  return std::chrono::steady_clock::duration::zero();
+}
+
+/**
+ * @details The fields are extracted from the payload directly, the only copies made are the ones owned by the response.
+ */
+bool parse_response(FrameView const& t_response, TMSTAResponse& t_parsed) noexcept {
+  FieldTokenizer fields{t_response.payload_, ','};
+  boost::string_ref subcmd;
+  if (t_response.header_ != motion_function::TMSTA or not fields.next(subcmd) or not to_int(subcmd, t_parsed.subcmd_)) {
+    return false;
+  }
+
+  t_parsed.data_.clear();
+  for (boost::string_ref field; fields.next(field);) {
+    t_parsed.data_.emplace_back(field.to_string());
+  }
+
+  return true;
+}
+
+bool parse_response(FrameView const& t_response, TMSCTResponse& t_parsed) noexcept {
+  FieldTokenizer fields{t_response.payload_, ','};
+  boost::string_ref id;
+  if (t_response.header_ != motion_function::TMSCT or not fields.next(id)) {
+    return false;
+  }
+
+  boost::string_ref script_result;
+  fields.next(script_result);
+
+  FieldTokenizer result{script_result, ';'};
+  boost::string_ref status;
+  result.next(status);
+
+  t_parsed.id_            = id.to_string();
+  t_parsed.script_result_ = status == "OK";
+  t_parsed.abnormal_line_.clear();
+  for (boost::string_ref line; result.next(line);) {
+    int line_num = 0;
+    if (not to_int(line, line_num)) {
+      return false;
+    }
+
+    t_parsed.abnormal_line_.push_back(line_num);
+  }
+
+  return true;
+}
+
+bool parse_response(FrameView const& t_response, CPERRResponse& t_parsed) noexcept {
+  FieldTokenizer fields{t_response.payload_, ','};
+  boost::string_ref code;
+  if (t_response.header_ != motion_function::CPERR or not fields.next(code)) {
+    return false;
+  }
+
+  int err_code = static_cast<int>(ErrorCode::NotInListenNode);
+  if (code != "F1" and not to_int(code, err_code)) {
+    return false;
+  }
+
+  t_parsed.err_ = static_cast<ErrorCode>(err_code);
+  return true;
+}
+
+/**
+ * @details If the data section is ill-formed, e.g. non-numeric sub command, none of the callbacks is called and the
+ *          in-flight table is left untouched.
+ *
+ *          TMSCT responses are matched by ID, TMSTA responses by sub command, and CPERR to the oldest request.
+ */
+bool ListenerHandle::handle_response(FrameView const& t_response) noexcept {
+  FieldTokenizer fields{t_response.payload_, ','};
+  boost::string_ref first_field;
+  if (not fields.next(first_field)) {
+    return false;
+  }
+
+  if (t_response.header_ == motion_function::TMSTA) {
+    TMSTAResponse resp{};
+    if (not parse_response(t_response, resp)) {
+      return false;
+    }
+
+    resp.round_trip_       = take_in_flight(this->tmsta_in_flight_, first_field);
+    this->last_round_trip_ = resp.round_trip_;
+    this->response_msg(resp);
+  } else if (t_response.header_ == motion_function::TMSCT) {
+    TMSCTResponse resp{};
+    if (not parse_response(t_response, resp)) {
+      return false;
+    }
+
+    resp.round_trip_       = take_in_flight(this->tmsct_in_flight_, first_field);
+    this->last_round_trip_ = resp.round_trip_;
+    this->response_msg(resp);
+  } else if (t_response.header_ == motion_function::CPERR) {
+    CPERRResponse resp{};
+    if (not parse_response(t_response, resp)) {
+      return false;
+    }
+
+    resp.round_trip_       = this->take_oldest_in_flight();
+    this->last_round_trip_ = resp.round_trip_;
     this->response_msg(resp);
+  } else {
+    return false;
   }
 
   this->response_msg();
+  return true;
 }
 
 }  // namespace tm_robot_listener
\ No newline at end of file
@@ -0,0 +1,453 @@
+#include <boost/asio.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/program_options.hpp>
+#include <boost/utility/string_ref.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tm_robot_listener/detail/tmr_frame_parser.hpp"
+#include "tmr_listener_handle/tmr_motion_function.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct MockOptions {
+  unsigned short port_;
+  std::string node_message_;
+  Clock::duration reply_delay_;
+  std::size_t cycles_; /*!< number of listen node to enter before exiting, 0 means forever */
+};
+
+/**
+ * @brief This function builds a message sent from TM robot, i.e., "$HEADER,LENGTH,DATA,*CS\r\n"
+ */
+template <typename Tag>
+std::string make_frame(tm_robot_listener::motion_function::Header<Tag> const& /*unused*/,
+                       boost::string_ref const t_payload) {
+  auto ret_val = std::string{Tag::HEADER()} + ',' + std::to_string(t_payload.size()) + ',';
+  ret_val.append(t_payload.data(), t_payload.size()).push_back(',');
+  ret_val += '*' + tm_robot_listener::motion_function::calculate_checksum(ret_val) + "\r\n";
+  return ret_val;
+}
+
+constexpr std::size_t MAX_PAYLOAD_SIZE   = 65536;                    /*!< longer length is taken as corrupted */
+constexpr std::size_t FRAME_TRAILER_SIZE = sizeof(",*00\r\n") - 1;  /*!< ",*CS\r\n" following the payload */
+
+/**
+ * @brief This function parses the length field, which must be a non-empty decimal number no larger than
+ *        MAX_PAYLOAD_SIZE
+ */
+bool parse_length(boost::string_ref const t_field, std::size_t& t_length) noexcept {
+  if (t_field.empty() or t_field.size() > std::to_string(MAX_PAYLOAD_SIZE).size()) {
+    return false;
+  }
+
+  t_length = 0;
+  for (auto const digit : t_field) {
+    if (digit < '0' or digit > '9') {
+      return false;
+    }
+
+    t_length = t_length * 10 + static_cast<std::size_t>(digit - '0');
+  }
+
+  return t_length <= MAX_PAYLOAD_SIZE;
+}
+
+/**
+ * @brief This function checks that t_frame ends with ",*XX\r\n", XX being 2 hex digits, the checksum itself is
+ *        verified by parse_frame
+ */
+bool ends_with_trailer(boost::string_ref const t_frame) noexcept {
+  if (t_frame.size() < FRAME_TRAILER_SIZE) {
+    return false;
+  }
+
+  auto const trailer = t_frame.substr(t_frame.size() - FRAME_TRAILER_SIZE);
+  auto const is_hex  = [](char const t_c) { return std::isxdigit(static_cast<unsigned char>(t_c)) != 0; };
+  return trailer.starts_with(",*") and is_hex(trailer[2]) and is_hex(trailer[3]) and trailer.ends_with("\r\n");
+}
+
+/**
+ * @brief This function checks that t_frame ends with ",*XX\r\n", XX being the checksum of the frame
+ */
+bool ends_with_checksum(boost::string_ref const t_frame) noexcept {
+  using tm_robot_listener::detail::hex_digit_value;
+  if (t_frame.size() < FRAME_TRAILER_SIZE + 1 or not ends_with_trailer(t_frame)) {
+    return false;
+  }
+
+  auto const star = t_frame.size() - FRAME_TRAILER_SIZE + 1;
+  auto const sum  = tm_robot_listener::motion_function::detail::xor_checksum(t_frame.data() + 1, t_frame.data() + star);
+  return hex_digit_value(t_frame[star + 1]) * 16 + hex_digit_value(t_frame[star + 2]) == sum;
+}
+
+/**
+ * @brief Statistics of one listen node, latency is the time between a message sent by the mock, and the first request
+ *        that follows it, i.e., the time tm_robot_listener and its handler take to react.
+ */
+class SessionStatistics {
+ private:
+  Clock::time_point start_ = Clock::now();
+  std::vector<Clock::duration> latencies_;
+  std::size_t frames_received_ = 0;
+  std::size_t frames_sent_     = 0;
+  std::size_t frames_rejected_ = 0;
+
+  static double to_us(Clock::duration const t_duration) noexcept {
+    return std::chrono::duration<double, std::micro>(t_duration).count();
+  }
+
+  double percentile(double const t_ratio) const noexcept {
+    auto const idx = static_cast<std::size_t>(t_ratio * static_cast<double>(this->latencies_.size() - 1) + 0.5);
+    return to_us(this->latencies_[idx]);
+  }
+
+ public:
+  void on_receive(bool const t_accepted) noexcept {
+    ++this->frames_received_;
+    this->frames_rejected_ += t_accepted ? 0 : 1;
+  }
+
+  void on_send() noexcept { ++this->frames_sent_; }
+
+  void record_latency(Clock::duration const t_latency) { this->latencies_.push_back(t_latency); }
+
+  void report(std::ostream& t_out) {
+    auto const elapsed = std::chrono::duration<double>(Clock::now() - this->start_).count();
+    auto const frames  = static_cast<double>(this->frames_received_ + this->frames_sent_);
+
+    t_out << std::fixed << std::setprecision(3) << "received: " << this->frames_received_
+          << ", sent: " << this->frames_sent_ << ", rejected: " << this->frames_rejected_ << ", elapsed: " << elapsed
+          << " s, throughput: " << std::setprecision(1) << (elapsed > 0 ? frames / elapsed : 0.0) << " frames/s\n";
+
+    if (not this->latencies_.empty()) {
+      std::sort(this->latencies_.begin(), this->latencies_.end());
+      t_out << "latency (us) p50: " << this->percentile(0.5) << ", p90: " << this->percentile(0.9)
+            << ", p99: " << this->percentile(0.99) << ", max: " << to_us(this->latencies_.back()) << '\n';
+    }
+  }
+};
+
+/**
+ * @brief One connection to tm_robot_listener. The session enters listen node as soon as it starts, answers TMSCT and
+ *        TMSTA requests the way TM robot does, and leaves listen node on ScriptExit().
+ */
+class MockSession : public std::enable_shared_from_this<MockSession> {
+ private:
+  boost::asio::io_service& io_service_;
+  boost::asio::ip::tcp::socket socket_;
+  MockOptions const& options_;
+  std::function<void()> on_finish_;
+
+  std::array<char, 4096> read_buffer_{};
+  std::string input_;
+  std::deque<std::string> write_queue_;
+
+  bool in_listen_node_       = false;
+  bool awaiting_request_     = false;
+  std::size_t cycles_done_   = 0;
+  Clock::time_point last_sent_{};
+  SessionStatistics statistics_;
+
+  /**
+   * @brief This function returns size of the first complete frame in input_, 0 if it is not yet received completely.
+   *        Scripts may contain "\r\n", therefore the length field is used instead of searching for the line ending.
+   *        The length is trusted only if the frame ends with ",*XX\r\n" where the length says it does, otherwise the
+   *        frame is rejected and the input is resynchronized on the line ending, see resync.
+   */
+  std::size_t next_frame_size() {
+    for (;;) {
+      this->input_.erase(0, this->input_.find('$'));  // drop garbage in front of the frame, if any
+
+      auto const line_end   = this->input_.find("\r\n");
+      auto const line_size  = line_end == std::string::npos ? 1 : line_end + 2;  // only '$' if not received yet
+      auto const header_end = this->input_.find(',');
+      auto const length_end = header_end == std::string::npos ? header_end : this->input_.find(',', header_end + 1);
+      if (length_end == std::string::npos or length_end > line_end) {
+        if (line_end == std::string::npos) {
+          return 0;
+        }
+
+        this->resync(line_size);  // the line ended before the length field did
+        continue;
+      }
+
+      auto const length_field = boost::string_ref{this->input_}.substr(header_end + 1, length_end - header_end - 1);
+      std::size_t length      = 0;
+      if (not parse_length(length_field, length)) {
+        this->resync(line_size);
+        continue;
+      }
+
+      auto const frame_size = length_end + 1 + length + FRAME_TRAILER_SIZE;
+      if (frame_size > this->input_.size()) {
+        auto const frame_end = this->checksummed_frame_end();
+        if (frame_end == std::string::npos) {
+          return 0;
+        }
+
+        this->resync(frame_end);  // the frame already ended, before the length says it does
+        continue;
+      }
+
+      if (ends_with_trailer(boost::string_ref{this->input_.data(), frame_size})) {
+        return frame_size;
+      }
+
+      this->resync(line_size);
+    }
+  }
+
+  /**
+   * @brief This function returns the end of the first line in input_ that ends with a matching checksum, i.e., where
+   *        the frame in front of input_ actually ends, npos if there is none
+   */
+  std::size_t checksummed_frame_end() const noexcept {
+    auto line_end = this->input_.find("\r\n");
+    while (line_end != std::string::npos and
+           not ends_with_checksum(boost::string_ref{this->input_.data(), line_end + 2})) {
+      line_end = this->input_.find("\r\n", line_end + 1);
+    }
+
+    return line_end == std::string::npos ? line_end : line_end + 2;
+  }
+
+  /**
+   * @brief This function rejects the frame in front of input_ with CPERR 01, and drops the first t_size bytes of
+   *        input_, i.e., up to the line ending, or only the leading '$' if no line ending is received yet
+   */
+  void resync(std::size_t const t_size) {
+    this->statistics_.on_receive(false);
+    this->reply(make_frame(tm_robot_listener::motion_function::CPERR, "01"));
+    this->input_.erase(0, t_size);
+  }
+
+  void enter_listen_node() {
+    this->in_listen_node_ = true;
+    this->statistics_     = SessionStatistics{};
+    this->send(make_frame(tm_robot_listener::motion_function::TMSCT, "0," + this->options_.node_message_));
+  }
+
+  void leave_listen_node() {
+    this->in_listen_node_ = false;
+    std::cout << "listen node #" << ++this->cycles_done_ << " done, ";
+    this->statistics_.report(std::cout);
+
+    if (this->options_.cycles_ != 0 and this->cycles_done_ >= this->options_.cycles_) {
+      this->on_finish_();
+      return;
+    }
+
+    this->reply_later([self = this->shared_from_this()]() { self->enter_listen_node(); });
+  }
+
+  template <typename Callback>
+  void reply_later(Callback t_callback) {
+    if (this->options_.reply_delay_ == Clock::duration::zero()) {
+      t_callback();
+      return;
+    }
+
+    auto timer = std::make_shared<boost::asio::steady_timer>(this->io_service_, this->options_.reply_delay_);
+    timer->async_wait([timer, t_callback](boost::system::error_code const& t_err) {
+      if (not t_err) {  // NOLINT, boost pre c++11 safe bool idiom
+        t_callback();
+      }
+    });
+  }
+
+  void reply(std::string t_frame) {
+    this->reply_later([self = this->shared_from_this(), frame = std::move(t_frame)]() { self->send(frame); });
+  }
+
+  void handle_frame(boost::string_ref const t_raw) {
+    using namespace tm_robot_listener;
+
+    if (this->awaiting_request_) {
+      this->statistics_.record_latency(Clock::now() - this->last_sent_);
+      this->awaiting_request_ = false;
+    }
+
+    auto const frame = parse_frame(t_raw);
+    this->statistics_.on_receive(frame.valid());
+
+    if (not frame.valid()) {
+      this->reply(make_frame(motion_function::CPERR, frame.error_ == FrameView::Error::BadChecksum ? "02" : "01"));
+      return;
+    }
+
+    FieldTokenizer fields{frame.payload_, ','};
+    boost::string_ref first_field;
+    fields.next(first_field);
+
+    if (frame.header_ == motion_function::TMSCT) {
+      if (not this->in_listen_node_) {
+        this->reply(make_frame(motion_function::CPERR, "F1"));
+        return;
+      }
+
+      this->reply(make_frame(motion_function::TMSCT, first_field.to_string() + ",OK"));
+      if (frame.payload_.find("ScriptExit()") != boost::string_ref::npos) {
+        this->reply_later([self = this->shared_from_this()]() { self->leave_listen_node(); });
+      }
+    } else if (frame.header_ == motion_function::TMSTA and first_field == "00") {
+      auto const status = this->in_listen_node_ ? "true," + this->options_.node_message_ : std::string{"false,"};
+      this->reply(make_frame(motion_function::TMSTA, "00," + status));
+    } else if (frame.header_ == motion_function::TMSTA and first_field == "01") {
+      boost::string_ref tag;
+      fields.next(tag);
+      this->reply(make_frame(motion_function::TMSTA, "01," + tag.to_string() + ",true"));
+    } else if (frame.header_ == motion_function::TMSTA) {
+      this->reply(make_frame(motion_function::CPERR, "04"));
+    } else {
+      this->reply(make_frame(motion_function::CPERR, "03"));
+    }
+  }
+
+  void start_read() {
+    auto const self = this->shared_from_this();
+    this->socket_.async_read_some(boost::asio::buffer(this->read_buffer_),
+                                  [self](boost::system::error_code const& t_err, std::size_t const t_byte_read) {
+                                    self->handle_read(t_err, t_byte_read);
+                                  });
+  }
+
+  void handle_read(boost::system::error_code const& t_err, std::size_t const t_byte_read) {
+    if (t_err) {  // NOLINT, boost pre c++11 safe bool idiom
+      std::cout << "connection closed (" << t_err.message() << "), ";
+      this->statistics_.report(std::cout);
+      return;
+    }
+
+    this->input_.append(this->read_buffer_.data(), t_byte_read);
+    for (auto size = this->next_frame_size(); size != 0; size = this->next_frame_size()) {
+      this->handle_frame(boost::string_ref{this->input_.data(), size});
+      this->input_.erase(0, size);
+    }
+
+    this->start_read();
+  }
+
+  void send(std::string t_frame) {
+    this->write_queue_.push_back(std::move(t_frame));
+    if (this->write_queue_.size() == 1) {
+      this->start_write();
+    }
+  }
+
+  void start_write() {
+    auto const self = this->shared_from_this();
+    boost::asio::async_write(this->socket_, boost::asio::buffer(this->write_queue_.front()),
+                             [self](boost::system::error_code const& t_err, std::size_t const /*unused*/) {
+                               self->handle_write(t_err);
+                             });
+  }
+
+  void handle_write(boost::system::error_code const& t_err) {
+    if (t_err) {  // NOLINT, boost pre c++11 safe bool idiom
+      return;
+    }
+
+    this->last_sent_        = Clock::now();
+    this->awaiting_request_ = true;
+    this->statistics_.on_send();
+
+    this->write_queue_.pop_front();
+    if (not this->write_queue_.empty()) {
+      this->start_write();
+    }
+  }
+
+ public:
+  MockSession(boost::asio::io_service& t_io_service, boost::asio::ip::tcp::socket t_socket,
+              MockOptions const& t_options, std::function<void()> t_on_finish)
+    : io_service_{t_io_service},
+      socket_{std::move(t_socket)},
+      options_{t_options},
+      on_finish_{std::move(t_on_finish)} {}
+
+  void start() {
+    this->enter_listen_node();
+    this->start_read();
+  }
+};
+
+/**
+ * @brief Accepts tm_robot_listener connections on the listen node port, each connection gets its own session
+ */
+class MockRobot {
+ private:
+  boost::asio::io_service& io_service_;
+  boost::asio::ip::tcp::acceptor acceptor_;
+  boost::asio::ip::tcp::socket socket_{io_service_};
+  MockOptions options_;
+
+  void start_accept() {
+    this->acceptor_.async_accept(this->socket_, [this](boost::system::error_code const& t_err) {
+      if (not t_err) {  // NOLINT, boost pre c++11 safe bool idiom
+        std::cout << "tm_robot_listener connected from " << this->socket_.remote_endpoint() << '\n';
+        auto const on_finish = [this]() { this->io_service_.stop(); };
+        std::make_shared<MockSession>(this->io_service_, std::move(this->socket_), this->options_, on_finish)->start();
+      }
+
+      if (this->acceptor_.is_open()) {
+        this->start_accept();
+      }
+    });
+  }
+
+ public:
+  MockRobot(boost::asio::io_service& t_io_service, MockOptions t_options)
+    : io_service_{t_io_service},
+      acceptor_{t_io_service, boost::asio::ip::tcp::endpoint{boost::asio::ip::tcp::v4(), t_options.port_}},
+      options_{std::move(t_options)} {
+    this->start_accept();
+  }
+};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  using namespace boost::program_options;
+  options_description mock_opt{"Mock TM robot options"};
+  mock_opt.add_options()                         //
+    ("help", "Show this help message and exit")  //
+    ("port", value<unsigned short>()->default_value(5890), "Port of the listen node")                 //
+    ("node-message", value<std::string>()->default_value("Listen1"), "Message sent on entering listen node")  //
+    ("delay-us", value<unsigned>()->default_value(0), "Delay before each reply, in microseconds")     //
+    ("cycles", value<std::size_t>()->default_value(0), "Exit after leaving listen node N times, 0 means never");
+
+  variables_map opt_map;
+  store(parse_command_line(argc, argv, mock_opt), opt_map);
+
+  if (opt_map.count("help") != 0) {
+    std::cout << mock_opt << '\n';
+    return 0;
+  }
+
+  MockOptions options{opt_map["port"].as<unsigned short>(), opt_map["node-message"].as<std::string>(),
+                      std::chrono::microseconds{opt_map["delay-us"].as<unsigned>()},
+                      opt_map["cycles"].as<std::size_t>()};
+
+  boost::asio::io_service io_service;
+  boost::asio::signal_set signals{io_service, SIGINT, SIGTERM};
+  signals.async_wait([&io_service](boost::system::error_code const& /*unused*/, int /*unused*/) { io_service.stop(); });
+
+  MockRobot robot{io_service, std::move(options)};
+  std::cout << "Mock TM robot listening on port " << opt_map["port"].as<unsigned short>() << std::endl;
+  io_service.run();
+
+  return 0;
+}
@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <boost/lexical_cast.hpp>
+
+#include "tmr_listener_handle/tmr_pvt_stream.hpp"
+
+namespace {
+
+constexpr auto PVT_STREAM_ID = "PVTStream";
+constexpr auto PVT_EXIT_ID   = "PVTExit";
+constexpr auto TAG_DONE      = "true";
+
+}  // namespace
+
+namespace tm_robot_listener {
+
+PVTStream::PVTStream() noexcept : PVTStream{Options{}} {}
+
+PVTStream::PVTStream(Options const& t_options) noexcept : options_{t_options} {
+  this->options_.look_ahead_ =
+    std::min(std::max<std::size_t>(this->options_.look_ahead_, 1), static_cast<std::size_t>(MAX_QUEUE_TAG));
+}
+
+bool PVTStream::push(PVTSample const& t_sample) noexcept {
+  return not this->finished_.load(std::memory_order_acquire) and this->samples_.try_push(t_sample);
+}
+
+/**
+ * @details finished_ is loaded before the queue is checked, every point pushed before finish() is therefore visible
+ *          if finished_ is.
+ */
+motion_function::BaseHeaderProductPtr PVTStream::next_command() noexcept {
+  using namespace motion_function;
+
+  auto const state         = this->state();
+  auto const producer_done = this->finished_.load(std::memory_order_acquire);
+  if (state == State::Idle and producer_done and this->samples_.empty()) {
+    this->state_.store(State::Done, std::memory_order_release);
+    return empty_command_list();
+  }
+
+  if (state != State::Idle and state != State::Streaming) {
+    return empty_command_list();
+  }
+
+  if (this->pending_tags_.size() < this->options_.look_ahead_ and not this->samples_.empty()) {
+    return this->next_batch();
+  }
+
+  if (not this->pending_tags_.empty()) {
+    return this->next_query();
+  }
+
+  if (state == State::Streaming and producer_done and this->samples_.empty()) {
+    this->state_.store(State::Exiting, std::memory_order_release);
+    return TMSCT << ID{PVT_EXIT_ID} << PVTExit() << End();
+  }
+
+  return empty_command_list();
+}
+
+/**
+ * @details Points are appended until the next one would exceed the frame budget, a frame carries at least one point.
+ *          PVTEnter is prepended to the first frame of the trajectory.
+ */
+motion_function::BaseHeaderProductPtr PVTStream::next_batch() noexcept {
+  using namespace motion_function;
+
+  auto builder          = TMSCT << ID{PVT_STREAM_ID};
+  std::size_t size      = 0;
+  std::size_t point_num = 0;
+  if (this->state() == State::Idle) {
+    auto const enter = PVTEnter(static_cast<int>(this->options_.mode_));
+    size += enter.name.size();
+    builder << enter;
+    this->state_.store(State::Streaming, std::memory_order_release);
+  }
+
+  for (auto sample = this->samples_.front(); sample != nullptr; sample = this->samples_.front()) {
+    auto const point = PVTPoint(sample->position_, sample->velocity_, sample->duration_);
+    if (point_num != 0 and size + point.name.size() > this->options_.frame_budget_) {
+      break;
+    }
+
+    size += point.name.size() + 2;  // "\r\n" between commands
+    ++point_num;
+    builder << point;
+    this->samples_.pop();
+  }
+
+  auto const tag  = this->next_tag_;
+  this->next_tag_ = this->next_tag_ % MAX_QUEUE_TAG + 1;
+  this->pending_tags_.push_back(tag);
+
+  return builder << QueueTag(tag) << End();
+}
+
+motion_function::BaseHeaderProductPtr PVTStream::next_query() noexcept {
+  using namespace motion_function;
+
+  auto const now = std::chrono::steady_clock::now();
+  if (this->query_sent_ or now - this->last_query_ < this->options_.poll_interval_) {
+    return empty_command_list();
+  }
+
+  this->query_sent_ = true;
+  this->last_query_ = now;
+  return TMSTA << QueueTagDone(this->pending_tags_.front()) << End();
+}
+
+/**
+ * @details The response of QueueTagDone is "01,<tag>,<status>". Once the oldest frame is done, the next one is polled
+ *          without waiting for the poll interval, since several frames may have been done meanwhile.
+ */
+void PVTStream::handle_response(TMSTAResponse const& t_response) noexcept {
+  if (t_response.subcmd_ != 1 or not this->query_sent_) {
+    return;
+  }
+
+  this->query_sent_ = false;
+
+  int tag = 0;
+  if (t_response.data_.size() < 2 or not boost::conversion::try_lexical_convert(t_response.data_[0], tag) or
+      this->pending_tags_.empty() or tag != this->pending_tags_.front() or t_response.data_[1] != TAG_DONE) {
+    return;
+  }
+
+  this->pending_tags_.pop_front();
+  this->last_query_ = std::chrono::steady_clock::time_point{};
+}
+
+void PVTStream::handle_response(TMSCTResponse const& t_response) noexcept {
+  auto const is_exit = t_response.id_ == PVT_EXIT_ID;
+  if (t_response.id_ != PVT_STREAM_ID and not is_exit) {
+    return;
+  }
+
+  if (not t_response.script_result_) {
+    this->state_.store(State::Failed, std::memory_order_release);
+  } else if (is_exit) {
+    this->state_.store(State::Done, std::memory_order_release);
+  }
+}
+
+void PVTStream::handle_response(CPERRResponse const& t_response) noexcept {
+  auto const state = this->state();
+  if (t_response.err_ != ErrorCode::NoError and (state == State::Streaming or state == State::Exiting)) {
+    this->state_.store(State::Failed, std::memory_order_release);
+  }
+}
+
+void PVTStream::reset() noexcept {
+  this->pending_tags_.clear();
+  this->next_tag_   = 1;
+  this->query_sent_ = false;
+  this->last_query_ = std::chrono::steady_clock::time_point{};
+  this->finished_.store(false, std::memory_order_release);
+  this->state_.store(State::Idle, std::memory_order_release);
+}
+
+}  // namespace tm_robot_listener